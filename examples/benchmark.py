@@ -16,3 +16,14 @@ for _ in range(total):
     avg += (time.time() - start) / total
 
 print(f"Average time taken to simulate: {avg} s")
+
+# subsequent solves with the same matrix can reuse the factorization of the last run
+
+avg = 0
+
+for _ in range(total):
+    start = time.time()
+    ez.sim.resolve()
+    avg += (time.time() - start) / total
+
+print(f"Average time taken to resolve: {avg} s")
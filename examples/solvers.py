@@ -0,0 +1,55 @@
+import sys
+
+from bfm import Bfm, CSim, Mesh_lepl1110, Ez_lepl1110
+
+# check that the sparse & iterative solvers agree with the direct one on the same problem
+
+bfm = Bfm()
+
+mesh = Mesh_lepl1110("meshes/8.lepl1110")
+ez = Ez_lepl1110(mesh, "problems/problem.txt")
+
+tol = 1e-8 # relative to the largest displacement
+
+def solve(solver: int, ordering: int | None = None, precond: int | None = None) -> list[float]:
+	ez.sim.set_solver(solver)
+
+	if ordering is not None:
+		ez.sim.set_ordering(ordering)
+
+	if precond is not None:
+		ez.sim.set_pcg(precond)
+
+	ez.sim.run()
+
+	# read the effects straight from the instance, as Instance.effects is cached
+
+	c_instance = ez.instance.c_instance
+	return [c_instance.effects[i] for i in range(c_instance.n_effects)]
+
+reference = solve(CSim.SOLVER_DIRECT)
+scale = max(abs(x) for x in reference) or 1
+
+cases = {
+	"sparse (ND)": (CSim.SOLVER_SPARSE, CSim.ORDERING_ND, None),
+	"sparse (AMD)": (CSim.SOLVER_SPARSE, CSim.ORDERING_AMD, None),
+	"PCG (Jacobi)": (CSim.SOLVER_PCG, None, CSim.PRECOND_JACOBI),
+	"PCG (SGS)": (CSim.SOLVER_PCG, None, CSim.PRECOND_SGS),
+	"PCG (IC0)": (CSim.SOLVER_PCG, None, CSim.PRECOND_IC0),
+}
+
+failed = False
+
+for name, (solver, ordering, precond) in cases.items():
+	effects = solve(solver, ordering, precond)
+	diffs = [abs(x - y) / scale for x, y in zip(effects, reference)]
+	diff = max(diffs)
+
+	# compared element-wise so that NaNs fail the check too (max may skip them)
+
+	ok = all(d < tol for d in diffs)
+	failed |= not ok
+
+	print(f"{name}: relative difference to direct solver {diff:.3e} ({'ok' if ok else 'FAIL'})")
+
+sys.exit(failed)
@@ -0,0 +1,157 @@
+// batched planar elasticity kernel for one vector width, included once per width by system.c
+// the including file defines:
+// - BATCH_KERNEL(name), the name of a kernel for this width
+// - BATCH_TARGET, the attributes needed to compile for it
+// - BATCH, the number of elements in a batch, i.e. the number of doubles in a vector
+
+// the stiffness matrices of BATCH elements are computed at once, each lane of a vector holding one element (structure of arrays)
+// each lane goes through the same arithmetic as fill_elasticity_elem, just with BATCH elements at a time
+
+typedef double BATCH_KERNEL(batch_t) __attribute__((vector_size(BATCH * sizeof(double))));
+typedef int64_t BATCH_KERNEL(batch_bits_t) __attribute__((vector_size(BATCH * sizeof(int64_t))));
+
+#define BATCH_VEC BATCH_KERNEL(batch_t)
+#define BATCH_BITS BATCH_KERNEL(batch_bits_t)
+
+BATCH_TARGET static inline BATCH_VEC BATCH_KERNEL(batch_abs)(BATCH_VEC x) {
+	return (BATCH_VEC) ((BATCH_BITS) x & INT64_MAX);
+}
+
+// elements of a batch
+// when there are fewer than BATCH elements left, the remaining lanes just repeat the last one and are ignored
+
+typedef struct {
+	size_t count;
+	elem_t elems[BATCH];
+
+	BATCH_VEC ke[ELEM_DOFS * ELEM_DOFS];
+	BATCH_VEC det_J[BATCH_POINTS];
+} BATCH_KERNEL(batch_block_t);
+
+BATCH_TARGET static void BATCH_KERNEL(fill_elasticity_batch)(BATCH_KERNEL(batch_block_t)* batch, bfm_rule_t* rule, double const a, double const b, double const c) {
+	bfm_elem_kind_t const kind = batch->elems[0].kind;
+	size_t const n = 2 * kind;
+
+	// gather coordinates into vectors
+
+	BATCH_VEC x[4];
+	BATCH_VEC y[4];
+
+	for (size_t j = 0; j < kind; j++) {
+		for (size_t l = 0; l < BATCH; l++) {
+			elem_t* const elem = &batch->elems[BFM_MIN(l, batch->count - 1)];
+
+			x[j][l] = elem->coord[0][j];
+			y[j][l] = elem->coord[1][j];
+		}
+	}
+
+	memset(batch->ke, 0, n * n * sizeof *batch->ke);
+
+	// go through integration points
+
+	for (size_t i = 0; i < rule->n_points; i++) {
+		double const weight = rule->weights[i];
+
+		double const* const dphi_dxsi = &rule->dphi_dxsi[i * kind];
+		double const* const dphi_deta = &rule->dphi_deta[i * kind];
+
+		// jacobian and its determinant
+
+		BATCH_VEC dx_dxsi = { 0 };
+		BATCH_VEC dx_deta = { 0 };
+		BATCH_VEC dy_dxsi = { 0 };
+		BATCH_VEC dy_deta = { 0 };
+
+		for (size_t j = 0; j < kind; j++) {
+			dx_dxsi += x[j] * dphi_dxsi[j];
+			dx_deta += x[j] * dphi_deta[j];
+			dy_dxsi += y[j] * dphi_dxsi[j];
+			dy_deta += y[j] * dphi_deta[j];
+		}
+
+		BATCH_VEC const det_J = BATCH_KERNEL(batch_abs)(dx_dxsi * dy_deta - dx_deta * dy_dxsi);
+		batch->det_J[i] = det_J;
+
+		// shape function derivative wrt element coordinates
+
+		BATCH_VEC dphi_dx[4];
+		BATCH_VEC dphi_dy[4];
+
+		for (size_t j = 0; j < kind; j++) {
+			dphi_dx[j] = (dphi_dxsi[j] * dy_deta - dphi_deta[j] * dy_dxsi) / det_J;
+			dphi_dy[j] = (dphi_deta[j] * dx_dxsi - dphi_dxsi[j] * dx_deta) / det_J;
+		}
+
+		// populate stiffness matrices
+
+		for (size_t j = 0; j < kind; j++) {
+			BATCH_VEC* const row_0 = &batch->ke[(2 * j + 0) * n];
+			BATCH_VEC* const row_1 = &batch->ke[(2 * j + 1) * n];
+
+			for (size_t k = 0; k < kind; k++) {
+				size_t const col = 2 * k;
+
+				BATCH_VEC const f_11 = a * dphi_dx[j] * dphi_dx[k] + c * dphi_dy[j] * dphi_dy[k];
+				BATCH_VEC const f_12 = b * dphi_dx[j] * dphi_dy[k] + c * dphi_dy[j] * dphi_dx[k];
+				BATCH_VEC const f_21 = b * dphi_dy[j] * dphi_dx[k] + c * dphi_dx[j] * dphi_dy[k];
+				BATCH_VEC const f_22 = a * dphi_dy[j] * dphi_dy[k] + c * dphi_dx[j] * dphi_dx[k];
+
+				row_0[col + 0] += det_J * weight * f_11;
+				row_0[col + 1] += det_J * weight * f_12;
+				row_1[col + 0] += det_J * weight * f_21;
+				row_1[col + 1] += det_J * weight * f_22;
+			}
+		}
+	}
+}
+
+// fill up to BATCH planar elements at once with the batched kernel
+// load vectors are still computed element by element, from the forces evaluated at the nodes beforehand
+
+BATCH_TARGET static int BATCH_KERNEL(fill_batch)(assembly_t* assembly, size_t const* elems, size_t count) {
+	bfm_system_t* const system = assembly->system;
+	bfm_obj_t* const obj = assembly->instance->obj;
+	bfm_rule_t* const rule = obj->rule;
+
+	BATCH_KERNEL(batch_block_t) batch;
+	batch.count = count;
+
+	for (size_t l = 0; l < count; l++) {
+		get_elem(&batch.elems[l], assembly->mesh, elems[l]);
+	}
+
+	BATCH_KERNEL(fill_elasticity_batch)(&batch, rule, assembly->a, assembly->b, assembly->c);
+
+	for (size_t l = 0; l < count; l++) {
+		elem_t* const elem = &batch.elems[l];
+		size_t const n = 2 * elem->kind;
+
+		double ke[ELEM_DOFS * ELEM_DOFS];
+		double fe[ELEM_DOFS];
+
+		for (size_t e = 0; e < n * n; e++) {
+			ke[e] = batch.ke[e][l];
+		}
+
+		memset(fe, 0, n * sizeof *fe);
+
+		for (size_t i = 0; i < rule->n_points; i++) {
+			double const* const phi = &rule->phi[i * elem->kind];
+			add_elem_load(elem, fe, phi, batch.det_J[i][l] * rule->weights[i], obj->material->rho, assembly->node_forces);
+		}
+
+		if (scatter_elem(system, elem, elems[l], ke, fe) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+#undef BATCH_VEC
+#undef BATCH_BITS
+
+#undef BATCH_KERNEL
+#undef BATCH_TARGET
+#undef BATCH
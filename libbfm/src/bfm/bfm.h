@@ -22,6 +22,10 @@ typedef struct {
 	bfm_alloc_t alloc;
 	bfm_realloc_t realloc;
 	bfm_free_t free;
+
+	// maximum number of threads used for assembly & for the band factorizations & solves, 1 by default
+	// smaller jobs use fewer threads, as spawning them wouldn't be worth it
+	size_t n_threads;
 } bfm_state_t;
 
 int bfm_state_create(bfm_state_t* state);
@@ -30,5 +34,6 @@ int bfm_state_destroy(bfm_state_t* state);
 int bfm_set_alloc(bfm_state_t* state, bfm_alloc_t alloc);
 int bfm_set_realloc(bfm_state_t* state, bfm_realloc_t realloc);
 int bfm_set_free(bfm_state_t* state, bfm_free_t free);
+int bfm_set_n_threads(bfm_state_t* state, size_t n_threads);
 
 int bfm_err_print(bfm_state_t* state);
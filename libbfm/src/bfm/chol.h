@@ -0,0 +1,72 @@
+#pragma once
+
+#include <bfm/math.h>
+#include <bfm/matrix.h>
+#include <bfm/perm.h>
+
+// sparse supernodal Cholesky factorization PAP^T = LL^T of a symmetric positive definite CSR matrix
+// the permutation is only ever read through, so A doesn't need to be permuted beforehand
+// supernodes are sets of consecutive columns of L sharing the same structure below their diagonal block, which are stored together as dense blocks
+// this lets the bulk of the work be done as dense matrix products, while only storing the non-zero entries of L (fill included)
+
+typedef struct {
+	bfm_state_t* state;
+	size_t n;
+
+	// symbolic factorization
+
+	size_t n_super;
+	size_t* super;       // columns of supernode s are super[s] to super[s + 1] - 1
+	size_t* col_super;   // supernode each column belongs to
+	size_t* row_offsets; // rows of supernode s are rows[row_offsets[s]] to rows[row_offsets[s + 1] - 1], sorted & starting with its own columns
+	size_t* rows;
+	size_t* val_offsets; // supernode s is a column-major block at values[val_offsets[s]], with one row per row index
+
+	size_t nnz; // number of entries of L, fill included
+
+	// numeric factorization
+
+	double* values;
+} bfm_chol_t;
+
+/**
+ * @brief Create the symbolic factorization of a matrix, i.e. the structure of its Cholesky factor
+ *
+ * @param chol, pointer to Cholesky factorization struct
+ * @param state, pointer to state struct
+ * @param matrix, symmetric CSR matrix, whose full (not just upper) pattern must be stored
+ * @param perm, fill-reducing permutation to factorize the matrix with, or NULL
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_chol_create(bfm_chol_t* chol, bfm_state_t* state, bfm_matrix_t* matrix, bfm_perm_t* perm);
+
+int bfm_chol_destroy(bfm_chol_t* chol);
+
+/**
+ * @brief Compute the numeric factorization of a matrix with the same pattern as the one the factorization was created with
+ *
+ * @param chol, pointer to Cholesky factorization struct
+ * @param matrix, symmetric positive definite CSR matrix
+ * @param perm, same permutation as the factorization was created with
+ * @return int, 0 if success, -1 if failure (including if the matrix isn't positive definite)
+ */
+int bfm_chol_factorize(bfm_chol_t* chol, bfm_matrix_t* matrix, bfm_perm_t* perm);
+
+/**
+ * @brief Solve LL^Tx = y inplace, y & x being in the permuted numbering
+ *
+ * @param chol, pointer to factorized Cholesky factorization struct
+ * @param vec, right-hand side on input, solution on output
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_chol_solve(bfm_chol_t* chol, bfm_vec_t* vec);
+
+/**
+ * @brief Solve LL^TX = Y inplace for r right-hand sides at once, Y & X being in the permuted numbering
+ *
+ * @param chol, pointer to factorized Cholesky factorization struct
+ * @param r, number of right-hand sides
+ * @param vec, nxr row-major block of right-hand sides on input, of solutions on output
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_chol_solve_multi(bfm_chol_t* chol, size_t r, bfm_vec_t* vec);
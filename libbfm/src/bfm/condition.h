@@ -24,10 +24,24 @@ typedef struct {
 	// for each node of the mesh, "true" indicates it's part of this boundary condition
 
 	bool* nodes;
+
+	// edges of the mesh with both their nodes part of this boundary condition, in increasing order
+	// these are resolved from nodes every time a system is assembled (see bfm_condition_resolve_edges)
+
+	size_t n_edges;
+	size_t* edges;
 } bfm_condition_t;
 
 int bfm_condition_create(bfm_condition_t* condition, bfm_state_t* state, bfm_mesh_t* mesh, bfm_condition_kind_t kind);
 int bfm_condition_destroy(bfm_condition_t* condition);
 
+/**
+ * @brief Find the edges of the mesh which are part of a boundary condition, from the edges of each of its nodes
+ *
+ * @param condition, pointer to condition struct
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_condition_resolve_edges(bfm_condition_t* condition);
+
 // TODO bfm_condition_populate to add nodes to boundary condition based on a passed function
 //      if blocks are available, there should be a bfm_condition_populate_b variant
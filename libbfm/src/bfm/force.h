@@ -17,8 +17,14 @@ typedef struct bfm_force_t bfm_force_t; // forward declaration
 
 typedef int (*bfm_force_funky_func_t)(bfm_force_t* force, bfm_vec_t* pos, bfm_vec_t* force_ref, void* data);
 
+// batch version, evaluating the force at n positions in a single call
+// pos holds the dim coordinates of each position one after the other, and force_ref receives the dim components of the force at each of them in the same layout
+
+typedef int (*bfm_force_funky_batch_func_t)(bfm_force_t* force, size_t n, double const* pos, double* force_ref, void* data);
+
 typedef struct {
-	bfm_force_funky_func_t func;
+	bfm_force_funky_func_t func;             // NULL if the force can only be evaluated in batches
+	bfm_force_funky_batch_func_t batch_func; // NULL if the force can only be evaluated one position at a time
 	void* data;
 } bfm_force_funky_t;
 
@@ -42,5 +48,19 @@ int bfm_force_set_linear(bfm_force_t* force, bfm_vec_t* vec);
 // TODO alternative bfm_force_set_funky_b if blocks are available
 
 int bfm_force_set_funky(bfm_force_t* force, bfm_force_funky_func_t func, void* data);
+int bfm_force_set_funky_batch(bfm_force_t* force, bfm_force_funky_batch_func_t func, void* data);
 
 int bfm_force_eval(bfm_force_t* force, bfm_vec_t* pos, bfm_vec_t* force_ref);
+
+/**
+ * @brief Evaluate a force at many positions at once
+ *
+ * Funky forces set with bfm_force_set_funky_batch are called once for all positions, others are evaluated position by position.
+ *
+ * @param force, pointer to force struct
+ * @param n, number of positions
+ * @param pos, dim coordinates of each position, one after the other
+ * @param force_ref, where to write the dim components of the force at each position, in the same layout as pos
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_force_eval_batch(bfm_force_t* force, size_t n, double const* pos, double* force_ref);
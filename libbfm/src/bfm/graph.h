@@ -0,0 +1,51 @@
+#pragma once
+
+#include <bfm/math.h>
+#include <bfm/matrix.h>
+#include <bfm/mesh.h>
+
+// adjacency graph in compressed form
+// the neighbours of node i are neighbours[offsets[i]] to neighbours[offsets[i + 1] - 1], sorted in increasing order
+// graphs created from meshes consider each node to be its own neighbour, so that they double as the sparsity pattern of the matrices assembled over them
+
+typedef struct {
+	bfm_state_t* state;
+
+	size_t n;
+	size_t* offsets;
+	size_t* neighbours;
+} bfm_graph_t;
+
+/**
+ * @brief Create the node adjacency graph of a mesh; two nodes are adjacent if they share an element
+ *
+ * @param graph, pointer to graph struct
+ * @param state, pointer to state struct
+ * @param mesh, mesh whose connectivity to use
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_graph_create_mesh(bfm_graph_t* graph, bfm_state_t* state, bfm_mesh_t* mesh);
+
+/**
+ * @brief Create a graph where each node of another graph is expanded to dim fully coupled nodes (e.g. from mesh nodes to DOFs)
+ *
+ * @param graph, pointer to graph struct
+ * @param src, graph to expand
+ * @param dim, number of nodes each node of src is expanded to
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_graph_create_expand(bfm_graph_t* graph, bfm_graph_t* src, size_t dim);
+
+/**
+ * @brief Create the adjacency graph of a matrix; nodes i and j are adjacent if the (i, j) entry is non-zero
+ *
+ * Sparse matrices use their sparsity pattern as is, so this is O(nnz) for them.
+ *
+ * @param graph, pointer to graph struct
+ * @param state, pointer to state struct
+ * @param matrix, matrix whose structure to use
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_graph_create_matrix(bfm_graph_t* graph, bfm_state_t* state, bfm_matrix_t* matrix);
+
+int bfm_graph_destroy(bfm_graph_t* graph);
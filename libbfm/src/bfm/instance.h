@@ -3,6 +3,8 @@
 #include <bfm/condition.h>
 #include <bfm/obj.h>
 
+typedef struct bfm_system_t bfm_system_t; // forward declaration, see bfm/system.h
+
 typedef struct {
 	bfm_state_t* state;
 	bfm_obj_t* obj;
@@ -12,8 +14,23 @@ typedef struct {
 	size_t n_effects;
 	double* effects;
 
+	// effects of each load case of the last bfm_sim_run_load_cases, one after the other
+
+	size_t n_cases;
+	double* case_effects;
+
+	// effects of each parameter set of the last bfm_sim_run_sweep, one after the other
+
+	size_t n_sweeps;
+	double* sweep_effects;
+
 	size_t n_conditions;
 	bfm_condition_t** conditions;
+
+	// factorized system of the last simulation run, kept around so that new loads can be solved for without refactorizing
+	// NULL if there is none
+
+	bfm_system_t* system;
 } bfm_instance_t;
 
 int bfm_instance_create(bfm_instance_t* instance, bfm_state_t* state, bfm_obj_t* obj);
@@ -21,3 +38,5 @@ int bfm_instance_destroy(bfm_instance_t* instance);
 
 int bfm_instance_set_n_conditions(bfm_instance_t* instance, size_t n_conditions);
 int bfm_instance_add_condition(bfm_instance_t* instance, bfm_condition_t* condition);
+
+int bfm_instance_release_system(bfm_instance_t* instance);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+
+// vector kernels, used by the factorizations & solves when the library isn't built with an external BLAS
+// this header is internal to the library, and isn't installed along with the others
+// there are SSE2, AVX2 & AVX-512 versions of each kernel on x86, the best one the CPU supports being picked the first time a kernel is called, and a NEON one on AArch64
+
+/**
+ * @brief y += alpha x
+ *
+ * @param n, number of entries
+ * @param alpha, scalar
+ * @param x, input vector
+ * @param y, output vector, which mustn't overlap with x
+ */
+void bfm_kernel_daxpy(size_t n, double alpha, double const* x, double* y);
+
+/**
+ * @brief Dot product of x & y
+ *
+ * @param n, number of entries
+ * @param x, first vector
+ * @param y, second vector
+ * @return double, dot product
+ */
+double bfm_kernel_ddot(size_t n, double const* x, double const* y);
+
+/**
+ * @brief C -= AB, with A mxk & C mxn column-major blocks
+ *
+ * Entry (l,j) of B is at b[l * b_l + j * b_j], so that B can be a column-major block (b_l = 1) as well as the transpose of one (b_j = 1).
+ *
+ * @param m, number of rows of A & C
+ * @param n, number of columns of B & C
+ * @param k, number of columns of A & rows of B
+ * @param a, A block
+ * @param lda, leading dimension of A
+ * @param b, B block
+ * @param b_l, stride between rows of B
+ * @param b_j, stride between columns of B
+ * @param c, C block, which mustn't overlap with A or B
+ * @param ldc, leading dimension of C
+ */
+void bfm_kernel_dgemm_sub(size_t m, size_t n, size_t k, double const* a, size_t lda, double const* b, size_t b_l, size_t b_j, double* c, size_t ldc);
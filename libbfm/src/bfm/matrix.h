@@ -10,6 +10,8 @@
 typedef enum {
 	BFM_MATRIX_KIND_FULL,
 	BFM_MATRIX_KIND_BAND,
+	BFM_MATRIX_KIND_CSR,
+	BFM_MATRIX_KIND_SYM_BAND,
 } bfm_matrix_kind_t;
 
 typedef enum {
@@ -21,11 +23,53 @@ typedef struct {
 	double* data;
 } bfm_matrix_full_t;
 
+// band matrices are stored in the layouts LAPACK expects, so that they can be handed to it as is (see WITH_LAPACKE)
+// general band matrices follow dgbtrf: column-major with a leading dimension of 3k+1, entry (i,j) being at row 2k+i-j of column j
+// the first k rows are only there for the fill-in of LAPACK's partial pivoting
+// symmetric band matrices follow dpbtrf with the lower half-band: entry (i,j), j >= i, is at row j-i of column i
+// i.e. row i of the upper half-band is stored contiguously, from (i,i) to (i,i+k)
+
 typedef struct {
 	size_t k; // bandwidth
 	double* data;
+
+	int* pivots; // row interchanges of the LAPACK factorization of general band matrices, NULL if there is none
 } bfm_matrix_band_t;
 
+// compressed sparse row matrix
+// the entries of row i are data[offsets[i]] to data[offsets[i + 1] - 1], with column indices in cols (sorted in increasing order)
+// the sparsity pattern is fixed at creation; only entries in the pattern can be set to a non-zero value
+
+typedef struct {
+	size_t nnz;
+	size_t* offsets;
+	size_t* cols;
+	double* data;
+
+	bool shared; // if set, offsets & cols are borrowed from elsewhere and aren't freed along with the matrix
+} bfm_matrix_csr_t;
+
+typedef enum {
+	BFM_PRECOND_KIND_NONE,
+	BFM_PRECOND_KIND_JACOBI,
+	BFM_PRECOND_KIND_SGS, // symmetric Gauss-Seidel
+	BFM_PRECOND_KIND_IC0, // incomplete Cholesky with zero fill-in
+} bfm_precond_kind_t;
+
+// settings & statistics of the preconditioned conjugate gradient solver
+
+typedef struct {
+	bfm_precond_kind_t precond;
+
+	double tol;      // stop once ||b - Ax|| <= tol * ||b||
+	size_t max_iter; // 0 means as many iterations as there are unknowns
+
+	// filled in by bfm_matrix_solve_pcg
+
+	size_t n_iter;
+	double residual; // relative residual reached
+} bfm_pcg_t;
+
 typedef struct {
 	bfm_state_t* state;
 
@@ -34,11 +78,11 @@ typedef struct {
 
 	size_t m;
 
-	// TODO property for symmetric matrices
-
 	union {
 		bfm_matrix_full_t full;
 		bfm_matrix_band_t band;
+		bfm_matrix_band_t sym_band; // only the upper half-band is stored
+		bfm_matrix_csr_t csr;
 	};
 } bfm_matrix_t;
 
@@ -54,16 +98,55 @@ typedef struct {
 int bfm_matrix_full_create(bfm_matrix_t* matrix, bfm_state_t* state, bfm_matrix_major_t major, size_t m);
 
 /**
- * @brief Create a band square matrix of size mxn
+ * @brief Create a band square matrix of size mxm, in LAPACK's general band layout
+ *
+ * @param matrix, pointer to matrix struct
+ * @param state, pointer to state struct
+ * @param m, number of rows/columns
+ * @param k, bandwidth of the matrix
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_matrix_band_create(bfm_matrix_t* matrix, bfm_state_t* state, size_t m, size_t k);
+
+/**
+ * @brief Create a symmetric band square matrix of size mxm, of which only the upper half-band is stored
+ *
+ * Writes to entries below the diagonal are ignored, as they're implied by symmetry.
+ * Factorization is done with LDL^T instead of LU (Cholesky if built with LAPACKE, so the matrix must then be positive definite).
  *
  * @param matrix, pointer to matrix struct
  * @param state, pointer to state struct
- * @param major, the way the matrix is represented in memory (order)
  * @param m, number of rows/columns
  * @param k, bandwidth of the matrix
  * @return int, 0 if success, -1 if failure
  */
-int bfm_matrix_band_create(bfm_matrix_t* matrix, bfm_state_t* state, bfm_matrix_major_t major, size_t m, size_t k);
+int bfm_matrix_sym_band_create(bfm_matrix_t* matrix, bfm_state_t* state, size_t m, size_t k);
+
+/**
+ * @brief Create a compressed sparse row square matrix of size mxm from a sparsity pattern
+ *
+ * @param matrix, pointer to matrix struct
+ * @param state, pointer to state struct
+ * @param m, number of rows/columns
+ * @param offsets, m + 1 offsets into cols of the start of each row (copied)
+ * @param cols, sorted column indices of the non-zero entries of each row (copied)
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_matrix_csr_create(bfm_matrix_t* matrix, bfm_state_t* state, size_t m, size_t const* offsets, size_t const* cols);
+
+/**
+ * @brief Create a compressed sparse row square matrix of size mxm which borrows its sparsity pattern instead of copying it
+ *
+ * The pattern must outlive the matrix. This lets many matrices share the pattern of a same mesh (see bfm/symbolic.h).
+ *
+ * @param matrix, pointer to matrix struct
+ * @param state, pointer to state struct
+ * @param m, number of rows/columns
+ * @param offsets, m + 1 offsets into cols of the start of each row (borrowed)
+ * @param cols, sorted column indices of the non-zero entries of each row (borrowed)
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_matrix_csr_create_shared(bfm_matrix_t* matrix, bfm_state_t* state, size_t m, size_t* offsets, size_t* cols);
 
 int bfm_matrix_copy(bfm_matrix_t* matrix, bfm_matrix_t* src);
 
@@ -98,10 +181,41 @@ int bfm_matrix_set(bfm_matrix_t* matrix, size_t i, size_t j, double val);
 
 int bfm_matrix_add(bfm_matrix_t* matrix, size_t i, size_t j, double val);
 
+// offset of entries which aren't stored (i.e. below the diagonal of symmetric band matrices)
+
+#define BFM_MATRIX_NO_OFFSET ((size_t) -1)
+
+/**
+ * @brief Find where the entries of a dense nxn block land in the storage of the matrix
+ *
+ * Entry (a,b) of the block is entry (dofs[a],dofs[b]) of the matrix.
+ * The offsets only depend on the structure of the matrix, so they can be computed once and reused for every bfm_matrix_add_block.
+ *
+ * @param matrix, pointer to matrix struct
+ * @param n, number of rows/columns of the block
+ * @param dofs, n row/column indices of the block in the matrix
+ * @param offsets, n*n offsets into the matrix' data, written in the same row-major order as the block (BFM_MATRIX_NO_OFFSET for entries which aren't stored)
+ * @return int, 0 if success, -1 if failure (including if an entry is outside of the band or sparsity pattern)
+ */
+int bfm_matrix_block_offsets(bfm_matrix_t* matrix, size_t n, size_t const* dofs, size_t* offsets);
+
+/**
+ * @brief Add a dense nxn row-major block to the matrix at offsets given by bfm_matrix_block_offsets
+ *
+ * @param matrix, pointer to matrix struct
+ * @param n, number of rows/columns of the block
+ * @param offsets, n*n offsets of the block's entries
+ * @param block, n*n row-major block to add
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_matrix_add_block(bfm_matrix_t* matrix, size_t n, size_t const* offsets, double const* block);
+
 size_t bfm_matrix_bandwidth(bfm_matrix_t* matrix);
 
 /**
- * @brief Apply LU decomposition to a matrix; store it in place
+ * @brief Apply LU decomposition to a matrix (LDL^T for symmetric band matrices); store it in place
+ *
+ * If built with LAPACKE, band matrices are factorized by LAPACK instead (dgbtrf with partial pivoting, and dpbtrf), and must then be solved with bfm_matrix_lu_solve(_multi) only.
  * 
  * @param A matrix 
  * @return int, 0 if success, -1 if failure
@@ -117,11 +231,45 @@ int bfm_matrix_lu(bfm_matrix_t* matrix);
  */
 int bfm_matrix_lu_solve(bfm_matrix_t* matrix, bfm_vec_t* y);
 
+/**
+ * @brief solve LUX = Y inplace for r right-hand sides at once
+ *
+ * The factor is only streamed through once for all right-hand sides, instead of once per right-hand side.
+ *
+ * @param matrix, LU matrix
+ * @param r, number of right-hand sides
+ * @param y, mxr row-major block of right-hand sides (entry (i,c) is y->data[i * r + c])
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_matrix_lu_solve_multi(bfm_matrix_t* matrix, size_t r, bfm_vec_t* y);
+
 /**
  * @brief solve a Ax = y system using LU decomposition
+ *
+ * If built with LAPACKE, band matrices are solved with dgbsv & dpbsv instead.
  * 
  * @param A, a matrix 
  * @param y
  * @return int 
  */
 int bfm_matrix_solve(bfm_matrix_t* matrix, bfm_vec_t* y);
+
+/**
+ * @brief Fill in default settings for the PCG solver (IC0 preconditioner, 1e-10 tolerance, no iteration limit)
+ *
+ * @param pcg, pointer to PCG settings struct
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_pcg_default(bfm_pcg_t* pcg);
+
+/**
+ * @brief solve a Ax = y system inplace using the preconditioned conjugate gradient method
+ *
+ * The matrix must be a symmetric positive definite CSR matrix; it is left untouched.
+ *
+ * @param matrix, a CSR matrix
+ * @param y, right-hand side on input, solution on output
+ * @param pcg, solver settings; number of iterations and final residual are written back to it
+ * @return int, 0 if success, -1 if failure (including if the solver didn't converge)
+ */
+int bfm_matrix_solve_pcg(bfm_matrix_t* matrix, bfm_vec_t* y, bfm_pcg_t* pcg);
@@ -28,6 +28,8 @@ typedef struct {
 	size_t* elements;
 } bfm_domain_t;
 
+typedef struct bfm_symbolic_t bfm_symbolic_t; // forward declaration, see bfm/symbolic.h
+
 typedef struct {
 	bfm_state_t* state;
 
@@ -45,10 +47,27 @@ typedef struct {
 	size_t n_domains;
 	bfm_domain_t* domains;
 	// bool* boundary_nodes;
+
+	// edge index, built along with the edges
+	// the edges node i is part of are node_edges[node_edge_offsets[i]] to node_edges[node_edge_offsets[i + 1] - 1], in increasing order
+	size_t* node_edge_offsets;
+	size_t* node_edges;
+
+	// element coloring, computed on demand by bfm_mesh_color
+	// no two elements of the same color share a node, so they can be assembled concurrently
+	// the elements of color i are color_elems[color_offsets[i]] to color_elems[color_offsets[i + 1] - 1]
+	size_t n_colors;
+	size_t* color_offsets;
+	size_t* color_elems;
+
+	// symbolic analysis of the mesh, NULL until the first system is created over it (see bfm_symbolic_get)
+	bfm_symbolic_t* symbolic;
 } bfm_mesh_t;
 
 int bfm_mesh_create(bfm_mesh_t* mesh, bfm_state_t* state, size_t dim, bfm_elem_kind_t kind);
 int bfm_mesh_destroy(bfm_mesh_t* mesh);
 
+int bfm_mesh_color(bfm_mesh_t* mesh);
+
 int bfm_mesh_read_lepl1110(bfm_mesh_t* mesh, bfm_state_t* state, char const* name);
 int bfm_mesh_read_wavefront(bfm_mesh_t* mesh, bfm_state_t* state, char const* name, bool full);
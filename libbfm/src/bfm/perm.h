@@ -1,8 +1,16 @@
 #pragma once
 
+#include <bfm/graph.h>
 #include <bfm/math.h>
 #include <bfm/matrix.h>
 
+typedef enum {
+	BFM_PERM_KIND_RCM = 0,   // reverse Cuthill-McKee, minimizes bandwidth
+	BFM_PERM_KIND_SLOAN = 1, // Sloan, minimizes profile
+	BFM_PERM_KIND_ND = 2,    // nested dissection, minimizes fill for sparse factorizations
+	BFM_PERM_KIND_AMD = 3,   // approximate minimum degree, minimizes fill for sparse factorizations
+} bfm_perm_kind_t;
+
 typedef struct {
 	bfm_state_t* state;
 
@@ -11,12 +19,125 @@ typedef struct {
 
 	size_t* perm;
 	size_t* inv_perm;
+
+	// workspaces for permuting in place, kept around between permutations
+
+	bool* visited;
+	double* buf;
+	size_t buf_len;
+
+	// bandwidth, profile & number of entries of the Cholesky factor (fill included) of the graph the permutation was created from, once renumbered
+
+	size_t bandwidth;
+	size_t profile;
+	size_t nnz_l;
 } bfm_perm_t;
 
 int bfm_perm_create(bfm_perm_t* perm, bfm_state_t* state, size_t m);
 int bfm_perm_destroy(bfm_perm_t* perm);
 
+// permute matrices & vectors in place
+// full matrices & vectors don't need any allocation past the first permutation, sparse ones need O(nnz) temporary memory, and band ones can't be permuted in place
+
 int bfm_perm_perm_matrix(bfm_perm_t* perm, bfm_matrix_t* matrix, bool inv);
 int bfm_perm_perm_vec(bfm_perm_t* perm, bfm_vec_t* vec, bool inv);
 
+/**
+ * @brief Permute the rows of a block of vectors in place
+ *
+ * @param perm, pointer to permutation struct
+ * @param vec, mxr row-major block whose rows to permute
+ * @param r, number of entries per row
+ * @param inv, whether to apply the inverse permutation
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_perm_rows(bfm_perm_t* perm, bfm_vec_t* vec, size_t r, bool inv);
+
+/**
+ * @brief Copy a matrix into another one (of any kind), permuting it on the way, so that the source matrix never needs to be permuted itself
+ *
+ * @param perm, pointer to permutation struct
+ * @param matrix, matrix to copy into, whose storage must be able to hold the permuted matrix
+ * @param src, matrix to copy from
+ * @param inv, whether to apply the inverse permutation
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_copy_matrix(bfm_perm_t* perm, bfm_matrix_t* matrix, bfm_matrix_t* src, bool inv);
+
+/**
+ * @brief Get the bandwidth a matrix would have once permuted, without permuting it
+ *
+ * @param perm, pointer to permutation struct
+ * @param matrix, matrix
+ * @return size_t, bandwidth of the permuted matrix
+ */
+size_t bfm_perm_bandwidth(bfm_perm_t* perm, bfm_matrix_t* matrix);
+
 int bfm_perm_rcm(bfm_perm_t* perm, bfm_matrix_t* mat);
+
+/**
+ * @brief Create a reverse Cuthill-McKee permutation from an adjacency graph, starting each component from a pseudo-peripheral node
+ *
+ * @param perm, pointer to permutation struct of the same size as the graph
+ * @param graph, adjacency graph to renumber
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_rcm_graph(bfm_perm_t* perm, bfm_graph_t* graph);
+
+/**
+ * @brief Create a Sloan permutation from an adjacency graph, which usually has a smaller profile but a larger bandwidth than RCM
+ *
+ * @param perm, pointer to permutation struct of the same size as the graph
+ * @param graph, adjacency graph to renumber
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_sloan(bfm_perm_t* perm, bfm_graph_t* graph);
+
+/**
+ * @brief Create a nested dissection permutation from an adjacency graph, for use with sparse factorizations rather than band ones
+ *
+ * @param perm, pointer to permutation struct of the same size as the graph
+ * @param graph, adjacency graph to renumber
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_nd(bfm_perm_t* perm, bfm_graph_t* graph);
+
+/**
+ * @brief Create an approximate minimum degree permutation from an adjacency graph, for use with sparse factorizations rather than band ones
+ *
+ * @param perm, pointer to permutation struct of the same size as the graph
+ * @param graph, adjacency graph to renumber
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_amd(bfm_perm_t* perm, bfm_graph_t* graph);
+
+/**
+ * @brief Create a permutation from an adjacency graph with the given ordering
+ *
+ * @param perm, pointer to permutation struct of the same size as the graph
+ * @param graph, adjacency graph to renumber
+ * @param kind, ordering to use
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_order(bfm_perm_t* perm, bfm_graph_t* graph, bfm_perm_kind_t kind);
+
+/**
+ * @brief Compute the bandwidth, profile & predicted nnz(L) of a graph once renumbered by a permutation, storing them in the permutation
+ *
+ * This is done automatically by the functions creating permutations.
+ *
+ * @param perm, pointer to permutation struct of the same size as the graph
+ * @param graph, adjacency graph
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_stats(bfm_perm_t* perm, bfm_graph_t* graph);
+
+/**
+ * @brief Expand a permutation of nodes to a permutation of their DOFs, keeping the DOFs of each node together (stats included)
+ *
+ * @param perm, pointer to permutation struct of size src->m * dim
+ * @param src, node permutation to expand
+ * @param dim, number of DOFs per node
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_perm_expand(bfm_perm_t* perm, bfm_perm_t* src, size_t dim);
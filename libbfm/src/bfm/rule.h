@@ -14,11 +14,24 @@ typedef struct {
 	double** points; // XXX this isn't an array of points, but an array of coordinates
 
 	bfm_shape_t shape;
+
+	// shape functions & their derivatives wrt xsi & eta tabulated at each integration point by bfm_rule_tabulate
+	// the value of the j'th shape function at the i'th point is phi[i * kind + j]
+	bool tabulated;
+
+	double* phi;
+	double* dphi_dxsi;
+	double* dphi_deta;
 } bfm_rule_t;
 
 int bfm_rule_create(bfm_rule_t* rule, bfm_state_t* state, size_t dim, bfm_elem_kind_t kind, size_t n_points);
 int bfm_rule_destroy(bfm_rule_t* rule);
 
+// (re)tabulate shape functions at the integration points
+// must be called again if the points are changed
+
+int bfm_rule_tabulate(bfm_rule_t* rule);
+
 // specific integration rule creation functions
 
 int bfm_rule_create_gauss_legendre(bfm_rule_t* rule, bfm_state_t* state, size_t dim, bfm_elem_kind_t kind);
@@ -2,6 +2,7 @@
 
 #include <bfm/force.h>
 #include <bfm/instance.h>
+#include <bfm/perm.h>
 
 typedef enum {
 	BFM_SIM_KIND_NONE = 0,
@@ -10,10 +11,41 @@ typedef enum {
 	BFM_SIM_KIND_AXISYMMETRIC_STRAIN = 3, // deplacement
 } bfm_sim_kind_t;
 
+typedef enum {
+	BFM_SIM_SOLVER_DIRECT = 0, // renumbering + band factorization
+	BFM_SIM_SOLVER_PCG = 1,    // preconditioned conjugate gradient on the sparse system, for symmetric systems only
+	BFM_SIM_SOLVER_SPARSE = 2, // renumbering + sparse supernodal Cholesky factorization, for symmetric systems only
+} bfm_sim_solver_t;
+
+// a load case replaces the forces of the simulation and the values of some of its boundary conditions
+
+typedef struct {
+	size_t n_forces;
+	bfm_force_t** forces;
+
+	// conditions whose values to override, and their values for this load case
+
+	size_t n_conditions;
+	bfm_condition_t** conditions;
+	double* values;
+} bfm_load_case_t;
+
+// a set of material parameters for a parameter sweep
+
+typedef struct {
+	double E;
+	double nu;
+	double rho;
+} bfm_sweep_params_t;
+
 typedef struct {
 	bfm_state_t* state;
 	bfm_sim_kind_t kind;
 
+	bfm_sim_solver_t solver;
+	bfm_pcg_t pcg; // settings for BFM_SIM_SOLVER_PCG
+	bfm_perm_kind_t ordering; // renumbering for BFM_SIM_SOLVER_DIRECT & BFM_SIM_SOLVER_SPARSE
+
 	size_t n_instances;
 	bfm_instance_t** instances;
 
@@ -30,4 +62,32 @@ int bfm_sim_add_instance(bfm_sim_t* sim, bfm_instance_t* instance);
 int bfm_sim_set_n_forces(bfm_sim_t* sim, size_t n_forces);
 int bfm_sim_add_force(bfm_sim_t* sim, bfm_force_t* force);
 
+// setting the solver also resets the ordering to the default one for that solver (AMD for sparse, RCM otherwise)
+// non-symmetric systems are always solved with BFM_SIM_SOLVER_DIRECT
+
+int bfm_sim_set_solver(bfm_sim_t* sim, bfm_sim_solver_t solver);
+int bfm_sim_set_pcg(bfm_sim_t* sim, bfm_precond_kind_t precond, double tol, size_t max_iter);
+int bfm_sim_set_ordering(bfm_sim_t* sim, bfm_perm_kind_t ordering);
+
 int bfm_sim_run(bfm_sim_t* sim);
+
+// solve again for the current forces, Neumann & Dirichlet values, reusing the factorized systems of the last run
+// only the right-hand side is reassembled (see bfm_system_assemble_loads), so the system matrix is never rebuilt
+// only valid if the mesh, material, simulation kind and set of conditions & their nodes haven't changed since then
+// instances without a factorized system are run from scratch
+
+int bfm_sim_resolve(bfm_sim_t* sim);
+
+// solve for many load cases at once with the same restrictions as bfm_sim_resolve
+// the factorization is streamed through only once for all load cases
+// effects of load case c are written to instance->case_effects[c * instance->n_effects] onwards for each instance
+
+int bfm_sim_run_load_cases(bfm_sim_t* sim, size_t n_cases, bfm_load_case_t* cases);
+
+// solve for many sets of material parameters, each one applied in turn to the material of every instance
+// stiffness is linear in Young's modulus, so parameter sets sharing the same Poisson's ratio share a single factorization and are solved for at once
+// the factorized system of the last run is reused for parameter sets with its Poisson's ratio, with the same restrictions as bfm_sim_resolve
+// materials are restored afterwards, and factorized systems no longer valid for them are released
+// effects of parameter set p are written to instance->sweep_effects[p * instance->n_effects] onwards for each instance
+
+int bfm_sim_run_sweep(bfm_sim_t* sim, size_t n_params, bfm_sweep_params_t* params);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <bfm/graph.h>
+#include <bfm/math.h>
+#include <bfm/matrix.h>
+#include <bfm/mesh.h>
+#include <bfm/perm.h>
+
+// symbolic analysis of a mesh
+// everything about the system matrices assembled over a mesh which only depends on its connectivity, and not on the values being assembled
+// it is built once per mesh, on the first system created over it, and cached on the mesh (see bfm_symbolic_get)
+
+// bfm_symbolic_t is forward-declared in bfm/mesh.h
+
+struct bfm_symbolic_t {
+	bfm_state_t* state;
+
+	size_t n;   // number of DOFs
+	size_t dim; // number of DOFs per node
+
+	// node adjacency graph of the mesh, orderings are computed on this rather than on the DOFs
+
+	bfm_graph_t graph;
+
+	// sparsity pattern of the DOFs, which system matrices share rather than copy (see bfm_matrix_csr_create_shared)
+
+	size_t nnz;
+	size_t* offsets;
+	size_t* cols;
+
+	// where the local matrix of each element lands in the data of a matrix with that sparsity pattern
+	// the offsets of element i are scatter[i * elem_dofs * elem_dofs] onwards, in the order given by bfm_matrix_block_offsets
+
+	size_t elem_dofs;
+	size_t* scatter;
+
+	// node ordering of the last kind asked for through bfm_symbolic_order, if has_ordering is set
+	// its bandwidth, profile & nnz_l statistics double as estimates of the fill of the factorization
+
+	bool has_ordering;
+	bfm_perm_kind_t ordering;
+	bfm_perm_t node_perm;
+};
+
+/**
+ * @brief Create the symbolic analysis of a mesh
+ *
+ * @param symbolic, pointer to symbolic analysis struct
+ * @param state, pointer to state struct
+ * @param mesh, mesh to analyse
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_symbolic_create(bfm_symbolic_t* symbolic, bfm_state_t* state, bfm_mesh_t* mesh);
+int bfm_symbolic_destroy(bfm_symbolic_t* symbolic);
+
+/**
+ * @brief Get the symbolic analysis cached on a mesh, creating it if there isn't one yet
+ *
+ * The cached analysis is released along with the mesh, and must be released by hand with bfm_symbolic_release if the elements of the mesh change.
+ *
+ * @param mesh, pointer to mesh struct
+ * @return bfm_symbolic_t*, symbolic analysis of the mesh, NULL if failure
+ */
+bfm_symbolic_t* bfm_symbolic_get(bfm_mesh_t* mesh);
+int bfm_symbolic_release(bfm_mesh_t* mesh);
+
+/**
+ * @brief Order the nodes of the mesh, reusing the previous ordering if it was of the same kind
+ *
+ * @param symbolic, pointer to symbolic analysis struct
+ * @param kind, kind of ordering
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_symbolic_order(bfm_symbolic_t* symbolic, bfm_perm_kind_t kind);
@@ -1,28 +1,133 @@
 #pragma once
 
+#include <bfm/chol.h>
 #include <bfm/force.h>
+#include <bfm/graph.h>
 #include <bfm/instance.h>
 #include <bfm/math.h>
 #include <bfm/matrix.h>
 #include <bfm/perm.h>
+#include <bfm/symbolic.h>
+
+// bfm_system_t is forward-declared in bfm/instance.h
+
+// layout the system matrix is assembled into, see the system creation functions
+// by default, A is assembled as a sparse matrix sharing the sparsity pattern of the mesh, which any solver can use and which is converted to a band matrix when factorized if need be
+// when band is set, the bandwidth of A under the given ordering is found from the connectivity of the mesh alone, and A is assembled straight into a band matrix of that width, already renumbered
+// such systems can only be factorized by bfm_system_factorize with the band solver (i.e. sparse unset)
 
 typedef struct {
+	bool band;
+	bfm_perm_kind_t ordering;
+} bfm_system_layout_t;
+
+struct bfm_system_t {
 	bfm_state_t* state;
 
 	size_t n;
+	size_t dim;
+	bool symmetric;  // if set, the system matrix is stored & factorized as a symmetric band matrix after renumbering
+	bool factorized; // if set, A has been renumbered & factorized in place and can only be used with bfm_system_solve
+	bool renumbered; // if set, A is already a band matrix renumbered with perm, e.g. if it was assembled that way (see bfm_system_layout_t)
+
+	bfm_perm_kind_t ordering; // ordering used by bfm_system_factorize, BFM_PERM_KIND_RCM by default
+	bool sparse;              // if set, bfm_system_factorize keeps A sparse and computes its supernodal Cholesky factorization (symmetric systems only)
 
+	bfm_symbolic_t* symbolic; // symbolic analysis of the mesh, owned by the mesh
 	bfm_perm_t perm;
 	bfm_matrix_t A;
 	bfm_vec_t b;
-} bfm_system_t;
 
-int bfm_system_create(bfm_system_t* system, bfm_state_t* state, size_t n);
+	bfm_chol_t chol; // factorization of A if sparse
+
+	// b is split into loads & the lifting of Dirichlet conditions, so that it can be rebuilt for new loads without A (see bfm_system_assemble_loads)
+	// constrained[i] is 1 + the index of the last Dirichlet condition constraining DOF i, 0 if there's none
+	// DOF i is then prescribed to be scales[i] times the value of that condition, and is eliminated from A as it's assembled
+	// only Dirichlet conditions have a lifting, lifts[lift_slots[c] * n] onwards being that of condition c per unit value
+
+	bool axisymmetric;
+
+	size_t n_conditions;
+	size_t n_lifts;
+	size_t* lift_slots;
+	double* lifts;
+	size_t* constrained;
+	double* scales;
+};
+
+int bfm_system_create(bfm_system_t* system, bfm_state_t* state, bfm_mesh_t* mesh);
 int bfm_system_destroy(bfm_system_t* system);
 
-int bfm_system_renumber(bfm_system_t* system);
+/**
+ * @brief Renumber the system with the given ordering and turn its matrix into a band matrix
+ *
+ * The bandwidth & profile of the resulting matrix are left in system->perm.
+ *
+ * @param system, pointer to system struct
+ * @param ordering, ordering to renumber with
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_system_renumber(bfm_system_t* system, bfm_perm_kind_t ordering);
+
+/**
+ * @brief Renumber the system matrix and factorize it in place, leaving b untouched
+ *
+ * @param system, pointer to system struct
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_system_factorize(bfm_system_t* system);
+
+/**
+ * @brief Solve the factorized system for a right-hand side, using only triangular solves
+ *
+ * @param system, pointer to a system factorized with bfm_system_factorize
+ * @param vec, right-hand side on input, solution on output (both in the original numbering)
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_system_solve(bfm_system_t* system, bfm_vec_t* vec);
+
+/**
+ * @brief Solve the factorized system for r right-hand sides at once
+ *
+ * @param system, pointer to a system factorized with bfm_system_factorize
+ * @param r, number of right-hand sides
+ * @param vec, nxr row-major block of right-hand sides on input, of solutions on output
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_system_solve_multi(bfm_system_t* system, size_t r, bfm_vec_t* vec);
 
 // system creation functions per kind
+// layout may be NULL to assemble A as a sparse matrix
+
+int bfm_system_create_planar_strain(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bfm_system_layout_t const* layout);
+int bfm_system_create_planar_stress(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bfm_system_layout_t const* layout);
+int bfm_system_create_axisymmetric_strain(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bfm_system_layout_t const* layout);
+
+/**
+ * @brief Rebuild the system vector for new forces & condition values, without reassembling the system matrix
+ *
+ * Only body forces, Neumann loads and the lifting of Dirichlet conditions are recomputed, so this works on factorized systems too.
+ * The instance must have the same conditions as when the system was created, though their values may have changed.
+ *
+ * @param system, pointer to a system created by one of the elasticity system creation functions
+ * @param instance, instance the system was created for
+ * @param n_forces, number of body forces
+ * @param forces, body forces
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_system_assemble_loads(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces);
 
-int bfm_system_create_planar_strain(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces);
-int bfm_system_create_planar_stress(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces);
-int bfm_system_create_axisymmetric_strain(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces);
+/**
+ * @brief Same as bfm_system_assemble_loads, but with the loads scaled by some factor
+ *
+ * Elasticity stiffness matrices are linear in Young's modulus, so a system factorized for a modulus E0 can be solved for a modulus E by scaling the loads by E0 / E.
+ * The lifting of Dirichlet conditions and loads on constrained DOFs aren't scaled, as the displacements they impose don't depend on the material.
+ *
+ * @param system, pointer to a system created by one of the elasticity system creation functions
+ * @param instance, instance the system was created for
+ * @param n_forces, number of body forces
+ * @param forces, body forces
+ * @param scale, factor to scale body forces & Neumann loads by
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_system_assemble_loads_scaled(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, double scale);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include <bfm/bfm.h>
+
+// teams of threads, used for assembly & for the band factorizations & solves
+// this header is internal to the library, and isn't installed along with the others
+// the calling thread acts as the first worker, and all workers run the same task, synchronizing with each other through bfm_team_sync
+
+typedef struct bfm_team_t bfm_team_t;
+
+typedef struct {
+	bfm_team_t* team;
+	size_t id;
+
+	pthread_t thread;
+	int rv;
+} bfm_team_worker_t;
+
+typedef void (*bfm_team_task_t)(bfm_team_worker_t* worker);
+
+struct bfm_team_t {
+	void* data;
+	bfm_team_task_t task;
+
+	size_t n_threads;
+	bool abort;
+
+	pthread_mutex_t start;
+	pthread_barrier_t barrier;
+};
+
+/**
+ * @brief Run a task on a team of threads, and wait for all of them to be done with it
+ *
+ * The team has as many threads as the state allows, but no more than the work makes worth spawning, and at least the calling thread.
+ * If not all threads could be spawned, the team just makes do with the ones that were, so tasks should split their work by team->n_threads rather than state->n_threads.
+ * A task reports failure by setting its worker's rv to -1, but must still go through as many bfm_team_sync calls as the other workers, so they aren't left waiting.
+ *
+ * @param state, library state
+ * @param task, task run by each worker
+ * @param data, data shared by all workers, as team->data
+ * @param work, rough number of flops of the whole task
+ * @return int, 0 if success, -1 if failure
+ */
+int bfm_team_run(bfm_state_t* state, bfm_team_task_t task, void* data, double work);
+
+/**
+ * @brief Wait for all the workers of a team to reach this point
+ *
+ * @param team, team of the calling worker
+ */
+void bfm_team_sync(bfm_team_t* team);
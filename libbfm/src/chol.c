@@ -0,0 +1,588 @@
+#include <string.h>
+
+#include <bfm/chol.h>
+
+#if defined(WITH_BLAS)
+# include <cblas.h>
+#else
+# include <bfm/kernel.h>
+#endif
+
+#define NONE ((size_t) -1)
+#define CHOL_NB 32 // width of the column blocks supernodes are factorized by
+
+// the factorized matrix is PAP^T, so its row k is row inv_perm[k] of A, and column j of A is its column perm[j]
+// without a permutation, this is just A
+
+#define ROW(k) (perm != NULL ? perm->inv_perm[k] : (k))
+#define COL(j) (perm != NULL ? perm->perm[j] : (j))
+
+// dense kernels, from BLAS if available and from our own otherwise (see bfm/kernel.h)
+
+static void axpy(size_t n, double alpha, double const* x, double* y) {
+#if defined(WITH_BLAS)
+	cblas_daxpy(n, alpha, x, 1, y, 1);
+#else
+	bfm_kernel_daxpy(n, alpha, x, y);
+#endif
+}
+
+// C -= AB^T, with A mxkk, B nxkk & C mxn column-major blocks
+
+static void gemm_sub_t(size_t m, size_t n, size_t kk, double const* a, size_t lda, double const* b, size_t ldb, double* c, size_t ldc) {
+	if (!m || !n || !kk) {
+		return;
+	}
+
+#if defined(WITH_BLAS)
+	cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans, m, n, kk, -1, a, lda, b, ldb, 1, c, ldc);
+#else
+	bfm_kernel_dgemm_sub(m, n, kk, a, lda, b, ldb, 1, c, ldc);
+#endif
+}
+
+// symbolic factorization
+
+int bfm_chol_create(bfm_chol_t* chol, bfm_state_t* state, bfm_matrix_t* matrix, bfm_perm_t* perm) {
+	int rv = -1;
+
+	memset(chol, 0, sizeof *chol);
+	chol->state = state;
+
+	if (matrix->kind != BFM_MATRIX_KIND_CSR) {
+		goto err_kind;
+	}
+
+	if (perm != NULL && (!perm->has_perm || perm->m != matrix->m)) {
+		goto err_kind;
+	}
+
+	bfm_matrix_csr_t* const csr = &matrix->csr;
+	size_t const n = matrix->m;
+
+	chol->n = n;
+
+	size_t* const parent = state->alloc(n * sizeof *parent);
+
+	if (parent == NULL) {
+		goto err_parent_alloc;
+	}
+
+	size_t* const ancestor = state->alloc(n * sizeof *ancestor);
+
+	if (ancestor == NULL) {
+		goto err_ancestor_alloc;
+	}
+
+	size_t* const mark = state->alloc(n * sizeof *mark);
+
+	if (mark == NULL) {
+		goto err_mark_alloc;
+	}
+
+	size_t* const col_count = state->alloc(n * sizeof *col_count);
+
+	if (col_count == NULL) {
+		goto err_col_count_alloc;
+	}
+
+	// elimination tree, with path compression through ancestor
+	// the parent of column j is the row of the first off-diagonal non-zero entry in column j of L
+
+	for (size_t k = 0; k < n; k++) {
+		parent[k] = NONE;
+		ancestor[k] = NONE;
+
+		size_t const row = ROW(k);
+
+		for (size_t p = csr->offsets[row]; p < csr->offsets[row + 1]; p++) {
+			size_t next;
+
+			for (size_t i = COL(csr->cols[p]); i != NONE && i < k; i = next) {
+				next = ancestor[i];
+				ancestor[i] = k;
+
+				if (next == NONE) {
+					parent[i] = k;
+				}
+			}
+		}
+	}
+
+	// column counts
+	// the non-zero entries of row k of L are the nodes of the subtree of the elimination tree spanned by the non-zero entries of row k of A
+
+	for (size_t j = 0; j < n; j++) {
+		col_count[j] = 1;
+		mark[j] = NONE;
+	}
+
+	for (size_t k = 0; k < n; k++) {
+		mark[k] = k;
+
+		size_t const row = ROW(k);
+
+		for (size_t p = csr->offsets[row]; p < csr->offsets[row + 1]; p++) {
+			for (size_t j = COL(csr->cols[p]); j < k && mark[j] != k; j = parent[j]) {
+				mark[j] = k;
+				col_count[j]++;
+			}
+		}
+	}
+
+	// fundamental supernodes
+	// column j can join the supernode of column j - 1 if its structure is that of column j - 1 minus its diagonal entry
+
+	chol->super = state->alloc((n + 1) * sizeof *chol->super);
+
+	if (chol->super == NULL) {
+		goto err_output_alloc;
+	}
+
+	chol->col_super = state->alloc(n * sizeof *chol->col_super);
+
+	if (chol->col_super == NULL) {
+		goto err_output_alloc;
+	}
+
+	chol->n_super = 0;
+
+	for (size_t j = 0; j < n; j++) {
+		if (j > 0 && parent[j - 1] == j && col_count[j] == col_count[j - 1] - 1) {
+			chol->col_super[j] = chol->n_super - 1;
+			continue;
+		}
+
+		chol->super[chol->n_super] = j;
+		chol->col_super[j] = chol->n_super++;
+	}
+
+	chol->super[chol->n_super] = n;
+
+	// offsets of the row indices & values of each supernode
+
+	chol->row_offsets = state->alloc((chol->n_super + 1) * sizeof *chol->row_offsets);
+
+	if (chol->row_offsets == NULL) {
+		goto err_output_alloc;
+	}
+
+	chol->val_offsets = state->alloc((chol->n_super + 1) * sizeof *chol->val_offsets);
+
+	if (chol->val_offsets == NULL) {
+		goto err_output_alloc;
+	}
+
+	chol->row_offsets[0] = 0;
+	chol->val_offsets[0] = 0;
+	chol->nnz = 0;
+
+	for (size_t s = 0; s < chol->n_super; s++) {
+		size_t const rows = col_count[chol->super[s]];
+		size_t const cols = chol->super[s + 1] - chol->super[s];
+
+		chol->row_offsets[s + 1] = chol->row_offsets[s] + rows;
+		chol->val_offsets[s + 1] = chol->val_offsets[s] + rows * cols;
+
+		chol->nnz += rows * cols - cols * (cols - 1) / 2;
+	}
+
+	// row indices of each supernode, which are those of its first column
+	// rows are visited in increasing order, so these come out sorted
+	// ancestor isn't needed anymore, so reuse it for the position at which to add the next row index of each supernode
+
+	chol->rows = state->alloc(chol->row_offsets[chol->n_super] * sizeof *chol->rows);
+
+	if (chol->rows == NULL) {
+		goto err_output_alloc;
+	}
+
+	size_t* const cursor = ancestor;
+
+	for (size_t s = 0; s < chol->n_super; s++) {
+		cursor[s] = chol->row_offsets[s];
+	}
+
+	for (size_t j = 0; j < n; j++) {
+		mark[j] = NONE;
+	}
+
+	for (size_t k = 0; k < n; k++) {
+		size_t const s = chol->col_super[k];
+
+		if (chol->super[s] == k) {
+			chol->rows[cursor[s]++] = k;
+		}
+
+		mark[k] = k;
+
+		size_t const row = ROW(k);
+
+		for (size_t p = csr->offsets[row]; p < csr->offsets[row + 1]; p++) {
+			for (size_t j = COL(csr->cols[p]); j < k && mark[j] != k; j = parent[j]) {
+				mark[j] = k;
+
+				size_t const j_super = chol->col_super[j];
+
+				if (chol->super[j_super] == j) {
+					chol->rows[cursor[j_super]++] = k;
+				}
+			}
+		}
+	}
+
+	chol->values = state->alloc(chol->val_offsets[chol->n_super] * sizeof *chol->values);
+
+	if (chol->values == NULL) {
+		goto err_output_alloc;
+	}
+
+	// success
+
+	rv = 0;
+
+err_output_alloc:
+
+	state->free(col_count);
+
+err_col_count_alloc:
+
+	state->free(mark);
+
+err_mark_alloc:
+
+	state->free(ancestor);
+
+err_ancestor_alloc:
+
+	state->free(parent);
+
+err_parent_alloc:
+err_kind:
+
+	// chol was zeroed out, so whatever of it was allocated can be freed as a whole
+
+	if (rv < 0) {
+		bfm_chol_destroy(chol);
+	}
+
+	return rv;
+}
+
+int bfm_chol_destroy(bfm_chol_t* chol) {
+	bfm_state_t* const state = chol->state;
+
+	state->free(chol->super);
+	state->free(chol->col_super);
+	state->free(chol->row_offsets);
+	state->free(chol->rows);
+	state->free(chol->val_offsets);
+	state->free(chol->values);
+
+	return 0;
+}
+
+// numeric factorization
+// this is left-looking: each supernode gathers the updates from all the supernodes with entries in its columns before being factorized itself
+// supernodes waiting to update another one are kept in a linked list per supernode (head & next), which they move along as they're used
+
+int bfm_chol_factorize(bfm_chol_t* chol, bfm_matrix_t* matrix, bfm_perm_t* perm) {
+	int rv = -1;
+
+	bfm_state_t* const state = chol->state;
+	bfm_matrix_csr_t* const csr = &matrix->csr;
+	size_t const n = chol->n;
+	size_t const n_super = chol->n_super;
+
+	if (matrix->kind != BFM_MATRIX_KIND_CSR || matrix->m != n) {
+		goto err_kind;
+	}
+
+	if (perm != NULL && (!perm->has_perm || perm->m != n)) {
+		goto err_kind;
+	}
+
+	// map[i] is the position of row i within the supernode being factorized
+
+	size_t* const map = state->alloc(n * sizeof *map);
+
+	if (map == NULL) {
+		goto err_map_alloc;
+	}
+
+	// head[s] is the first supernode waiting to update supernode s, next[d] the one after supernode d
+	// pos[d] is the position of the first row of supernode d which is yet to be used for updating
+
+	size_t* const head = state->alloc(n_super * sizeof *head);
+
+	if (head == NULL) {
+		goto err_head_alloc;
+	}
+
+	size_t* const next = state->alloc(n_super * sizeof *next);
+
+	if (next == NULL) {
+		goto err_next_alloc;
+	}
+
+	size_t* const pos = state->alloc(n_super * sizeof *pos);
+
+	if (pos == NULL) {
+		goto err_pos_alloc;
+	}
+
+	// workspace for the dense update blocks, which are never larger than the largest supernode's rows times the largest supernode's columns
+
+	size_t max_rows = 0;
+	size_t max_cols = 0;
+
+	for (size_t s = 0; s < n_super; s++) {
+		max_rows = BFM_MAX(max_rows, chol->row_offsets[s + 1] - chol->row_offsets[s]);
+		max_cols = BFM_MAX(max_cols, chol->super[s + 1] - chol->super[s]);
+	}
+
+	double* const update = state->alloc(max_rows * max_cols * sizeof *update);
+
+	if (update == NULL && max_rows * max_cols != 0) {
+		goto err_update_alloc;
+	}
+
+	memset(chol->values, 0, chol->val_offsets[n_super] * sizeof *chol->values);
+
+	for (size_t s = 0; s < n_super; s++) {
+		head[s] = NONE;
+	}
+
+	for (size_t s = 0; s < n_super; s++) {
+		size_t const first = chol->super[s];
+		size_t const last = chol->super[s + 1];
+		size_t const cols = last - first;
+
+		size_t const* const rows = chol->rows + chol->row_offsets[s];
+		size_t const n_rows = chol->row_offsets[s + 1] - chol->row_offsets[s];
+
+		double* const L = chol->values + chol->val_offsets[s];
+
+		for (size_t p = 0; p < n_rows; p++) {
+			map[rows[p]] = p;
+		}
+
+		// scatter the lower part of the columns of A into the supernode
+
+		for (size_t j = first; j < last; j++) {
+			size_t const row = ROW(j);
+
+			for (size_t p = csr->offsets[row]; p < csr->offsets[row + 1]; p++) {
+				size_t const i = COL(csr->cols[p]);
+
+				if (i >= j) {
+					L[map[i] + (j - first) * n_rows] = csr->data[p];
+				}
+			}
+		}
+
+		// gather updates from descendant supernodes
+
+		size_t next_d;
+
+		for (size_t d = head[s]; d != NONE; d = next_d) {
+			next_d = next[d];
+
+			size_t const d_cols = chol->super[d + 1] - chol->super[d];
+			size_t const* const d_rows = chol->rows + chol->row_offsets[d];
+			size_t const d_n_rows = chol->row_offsets[d + 1] - chol->row_offsets[d];
+
+			double const* const D = chol->values + chol->val_offsets[d];
+
+			// rows p0 to p1 - 1 of supernode d fall within the columns of supernode s
+
+			size_t const p0 = pos[d];
+			size_t p1 = p0;
+
+			while (p1 < d_n_rows && d_rows[p1] < last) {
+				p1++;
+			}
+
+			size_t const m = d_n_rows - p0;
+			size_t const k = p1 - p0;
+
+			// update = -D[p0:, :] * D[p0:p1, :]^T, of which only the lower part is needed
+
+			memset(update, 0, m * k * sizeof *update);
+			gemm_sub_t(m, k, d_cols, D + p0, d_n_rows, D + p0, d_n_rows, update, m);
+
+			for (size_t jj = 0; jj < k; jj++) {
+				double* const L_col = L + (d_rows[p0 + jj] - first) * n_rows;
+				double const* const update_col = update + jj * m;
+
+				for (size_t ii = jj; ii < m; ii++) {
+					L_col[map[d_rows[p0 + ii]]] += update_col[ii];
+				}
+			}
+
+			// move on to the next supernode supernode d has to update, if any
+
+			pos[d] = p1;
+
+			if (p1 < d_n_rows) {
+				size_t const next_s = chol->col_super[d_rows[p1]];
+
+				next[d] = head[next_s];
+				head[next_s] = d;
+			}
+		}
+
+		// factorize the supernode itself (both its dense diagonal block & the rows below it), by blocks of CHOL_NB columns
+		// each block first receives the contributions of the columns of the supernode left of it at once, as a dense matrix product, and is then factorized column by column
+		// the upper triangle of the diagonal block is never read, so it's updated along with the rest rather than splitting the product
+
+		for (size_t b0 = 0; b0 < cols; b0 += CHOL_NB) {
+			size_t const b1 = BFM_MIN(b0 + CHOL_NB, cols);
+
+			gemm_sub_t(n_rows - b0, b1 - b0, b0, L + b0, n_rows, L + b0, n_rows, L + b0 + b0 * n_rows, n_rows);
+
+			for (size_t jj = b0; jj < b1; jj++) {
+				double* const L_col = L + jj * n_rows;
+
+				for (size_t c = b0; c < jj; c++) {
+					double const* const L_prev = L + c * n_rows;
+					axpy(n_rows - jj, -L_prev[jj], L_prev + jj, L_col + jj);
+				}
+
+				// matrix isn't positive definite (or the pivot is NaN)
+
+				if (!(L_col[jj] > 0)) {
+					goto err_not_pd;
+				}
+
+				double const diag = sqrt(L_col[jj]);
+				L_col[jj] = diag;
+
+				for (size_t ii = jj + 1; ii < n_rows; ii++) {
+					L_col[ii] /= diag;
+				}
+			}
+		}
+
+		// queue supernode s for updating the supernode of its first row below the diagonal block
+
+		pos[s] = cols;
+
+		if (cols < n_rows) {
+			size_t const next_s = chol->col_super[rows[cols]];
+
+			next[s] = head[next_s];
+			head[next_s] = s;
+		}
+	}
+
+	// success
+
+	rv = 0;
+
+err_not_pd:
+
+	state->free(update);
+
+err_update_alloc:
+
+	state->free(pos);
+
+err_pos_alloc:
+
+	state->free(next);
+
+err_next_alloc:
+
+	state->free(head);
+
+err_head_alloc:
+
+	state->free(map);
+
+err_map_alloc:
+err_kind:
+
+	return rv;
+}
+
+// solving
+// y is an nxr row-major block, so that the factor is only read once for all right-hand sides
+
+static void chol_solve(bfm_chol_t* chol, double* y, size_t r) {
+	// forward substitution (LY' = Y)
+
+	for (size_t s = 0; s < chol->n_super; s++) {
+		size_t const first = chol->super[s];
+		size_t const cols = chol->super[s + 1] - first;
+
+		size_t const* const rows = chol->rows + chol->row_offsets[s];
+		size_t const n_rows = chol->row_offsets[s + 1] - chol->row_offsets[s];
+
+		double const* const L = chol->values + chol->val_offsets[s];
+
+		for (size_t jj = 0; jj < cols; jj++) {
+			double const* const L_col = L + jj * n_rows;
+			double* const y_j = y + (first + jj) * r;
+
+			for (size_t q = 0; q < r; q++) {
+				y_j[q] /= L_col[jj];
+			}
+
+			for (size_t p = jj + 1; p < n_rows; p++) {
+				double* const y_i = y + rows[p] * r;
+
+				for (size_t q = 0; q < r; q++) {
+					y_i[q] -= L_col[p] * y_j[q];
+				}
+			}
+		}
+	}
+
+	// backward substitution (L^TX = Y')
+
+	for (size_t s = chol->n_super; s-- > 0;) {
+		size_t const first = chol->super[s];
+		size_t const cols = chol->super[s + 1] - first;
+
+		size_t const* const rows = chol->rows + chol->row_offsets[s];
+		size_t const n_rows = chol->row_offsets[s + 1] - chol->row_offsets[s];
+
+		double const* const L = chol->values + chol->val_offsets[s];
+
+		for (size_t jj = cols; jj-- > 0;) {
+			double const* const L_col = L + jj * n_rows;
+			double* const y_j = y + (first + jj) * r;
+
+			for (size_t p = jj + 1; p < n_rows; p++) {
+				double const* const y_i = y + rows[p] * r;
+
+				for (size_t q = 0; q < r; q++) {
+					y_j[q] -= L_col[p] * y_i[q];
+				}
+			}
+
+			for (size_t q = 0; q < r; q++) {
+				y_j[q] /= L_col[jj];
+			}
+		}
+	}
+}
+
+int bfm_chol_solve(bfm_chol_t* chol, bfm_vec_t* vec) {
+	if (vec->n != chol->n) {
+		return -1;
+	}
+
+	chol_solve(chol, vec->data, 1);
+	return 0;
+}
+
+int bfm_chol_solve_multi(bfm_chol_t* chol, size_t r, bfm_vec_t* vec) {
+	if (vec->n != chol->n * r) {
+		return -1;
+	}
+
+	chol_solve(chol, vec->data, r);
+	return 0;
+}
@@ -17,6 +17,9 @@ int bfm_condition_create(bfm_condition_t* condition, bfm_state_t* state, bfm_mes
 
 	memset(condition->nodes, 0, size);
 
+	condition->n_edges = 0;
+	condition->edges = NULL;
+
 	return 0;
 }
 
@@ -25,5 +28,68 @@ int bfm_condition_destroy(bfm_condition_t* condition) {
 
 	state->free(condition->nodes);
 
+	if (condition->edges != NULL) {
+		state->free(condition->edges);
+	}
+
+	return 0;
+}
+
+static int cmp_edge_index(void const* _a, void const* _b) {
+	size_t const a = *(size_t const*) _a;
+	size_t const b = *(size_t const*) _b;
+
+	return (a > b) - (a < b);
+}
+
+int bfm_condition_resolve_edges(bfm_condition_t* condition) {
+	bfm_state_t* const state = condition->state;
+	bfm_mesh_t* const mesh = condition->mesh;
+
+	if (mesh->node_edge_offsets == NULL) {
+		return -1;
+	}
+
+	// there can't be more edges than the edges of all the nodes of the condition
+
+	size_t max_edges = 0;
+
+	for (size_t i = 0; i < mesh->n_nodes; i++) {
+		if (condition->nodes[i]) {
+			max_edges += mesh->node_edge_offsets[i + 1] - mesh->node_edge_offsets[i];
+		}
+	}
+
+	size_t* const edges = state->realloc(condition->edges, BFM_MAX(max_edges, 1) * sizeof *edges);
+
+	if (edges == NULL) {
+		return -1;
+	}
+
+	condition->edges = edges;
+
+	// each edge is found from its first node, so it's only counted once
+
+	size_t n_edges = 0;
+
+	for (size_t i = 0; i < mesh->n_nodes; i++) {
+		if (!condition->nodes[i]) {
+			continue;
+		}
+
+		for (size_t j = mesh->node_edge_offsets[i]; j < mesh->node_edge_offsets[i + 1]; j++) {
+			size_t const e = mesh->node_edges[j];
+			bfm_edge_t* const edge = &mesh->edges[e];
+
+			if (edge->nodes[0] == i && condition->nodes[edge->nodes[1]]) {
+				edges[n_edges++] = e;
+			}
+		}
+	}
+
+	qsort(edges, n_edges, sizeof *edges, cmp_edge_index);
+
+	condition->n_edges = n_edges;
+
 	return 0;
 }
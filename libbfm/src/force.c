@@ -46,6 +46,17 @@ int bfm_force_set_funky(bfm_force_t* force, bfm_force_funky_func_t func, void* d
 	force->kind = BFM_FORCE_KIND_FUNKY;
 
 	force->funky.func = func;
+	force->funky.batch_func = NULL;
+	force->funky.data = data;
+
+	return 0;
+}
+
+int bfm_force_set_funky_batch(bfm_force_t* force, bfm_force_funky_batch_func_t func, void* data) {
+	force->kind = BFM_FORCE_KIND_FUNKY;
+
+	force->funky.func = NULL;
+	force->funky.batch_func = func;
 	force->funky.data = data;
 
 	return 0;
@@ -69,10 +80,14 @@ int eval_linear(bfm_force_t* force, bfm_vec_t* pos, bfm_vec_t* force_ref) {
 		return -1;
 	}
 
-	return -1;
+	return 0;
 }
 
 int eval_funky(bfm_force_t* force, bfm_vec_t* pos, bfm_vec_t* force_ref) {
+	if (force->funky.func == NULL) {
+		return force->funky.batch_func(force, 1, pos->data, force_ref->data, force->funky.data);
+	}
+
 	return force->funky.func(force, pos, force_ref, force->funky.data);
 }
 
@@ -97,3 +112,53 @@ int bfm_force_eval(bfm_force_t* force, bfm_vec_t* pos, bfm_vec_t* force_ref) {
 
 	return -1;
 }
+
+// batch evaluation
+// linear forces are the same constant everywhere, so they're just copied over
+
+int bfm_force_eval_batch(bfm_force_t* force, size_t n, double const* pos, double* force_ref) {
+	size_t const dim = force->dim;
+
+	if (force->kind == BFM_FORCE_KIND_NONE) {
+		memset(force_ref, 0, n * dim * sizeof *force_ref);
+		return 0;
+	}
+
+	if (force->kind == BFM_FORCE_KIND_LINEAR) {
+		for (size_t i = 0; i < n; i++) {
+			memcpy(&force_ref[i * dim], force->linear.force.data, dim * sizeof *force_ref);
+		}
+
+		return 0;
+	}
+
+	if (force->kind != BFM_FORCE_KIND_FUNKY) {
+		return -1;
+	}
+
+	if (force->funky.batch_func != NULL) {
+		return force->funky.batch_func(force, n, pos, force_ref, force->funky.data);
+	}
+
+	// funky forces without a batch function are evaluated position by position, through vectors viewing into pos & force_ref
+
+	for (size_t i = 0; i < n; i++) {
+		bfm_vec_t pos_view = {
+			.state = force->state,
+			.n = dim,
+			.data = (double*) &pos[i * dim],
+		};
+
+		bfm_vec_t force_view = {
+			.state = force->state,
+			.n = dim,
+			.data = &force_ref[i * dim],
+		};
+
+		if (force->funky.func(force, &pos_view, &force_view, force->funky.data) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
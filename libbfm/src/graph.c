@@ -0,0 +1,272 @@
+#include <string.h>
+
+#include <bfm/graph.h>
+
+static int cmp_node(void const* _a, void const* _b) {
+	size_t const a = *(size_t const*) _a;
+	size_t const b = *(size_t const*) _b;
+
+	return (a > b) - (a < b);
+}
+
+int bfm_graph_create_mesh(bfm_graph_t* graph, bfm_state_t* state, bfm_mesh_t* mesh) {
+	int rv = -1;
+
+	memset(graph, 0, sizeof *graph);
+	graph->state = state;
+
+	size_t const n = mesh->n_nodes;
+	size_t const kind = mesh->kind;
+
+	graph->n = n;
+
+	// build node-to-element incidence lists first
+	// the elements of node i are incidence[incidence_offsets[i]] to incidence[incidence_offsets[i + 1] - 1]
+
+	size_t* const incidence_offsets = state->alloc((n + 1) * sizeof *incidence_offsets);
+
+	if (incidence_offsets == NULL) {
+		goto err_incidence_offsets_alloc;
+	}
+
+	memset(incidence_offsets, 0, (n + 1) * sizeof *incidence_offsets);
+
+	for (size_t i = 0; i < mesh->n_elems * kind; i++) {
+		incidence_offsets[mesh->elems[i] + 1]++;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		incidence_offsets[i + 1] += incidence_offsets[i];
+	}
+
+	size_t* const incidence = state->alloc(mesh->n_elems * kind * sizeof *incidence);
+
+	if (incidence == NULL) {
+		goto err_incidence_alloc;
+	}
+
+	// use the offsets of the next node as a cursor while filling, then shift them back into place
+
+	for (size_t i = 0; i < mesh->n_elems; i++) {
+		for (size_t j = 0; j < kind; j++) {
+			size_t const node = mesh->elems[i * kind + j];
+			incidence[incidence_offsets[node]++] = i;
+		}
+	}
+
+	memmove(incidence_offsets + 1, incidence_offsets, n * sizeof *incidence_offsets);
+	incidence_offsets[0] = 0;
+
+	// marker array to avoid adding the same neighbour twice
+	// marker[j] == i + 1 means j has already been added as a neighbour of i
+
+	size_t* const marker = state->alloc(n * sizeof *marker);
+
+	if (marker == NULL) {
+		goto err_marker_alloc;
+	}
+
+	memset(marker, 0, n * sizeof *marker);
+
+	graph->offsets = state->alloc((n + 1) * sizeof *graph->offsets);
+
+	if (graph->offsets == NULL) {
+		goto err_offsets_alloc;
+	}
+
+	// first pass: count neighbours of each node (including itself)
+
+	graph->offsets[0] = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		size_t deg = 1;
+		marker[i] = i + 1;
+
+		for (size_t e = incidence_offsets[i]; e < incidence_offsets[i + 1]; e++) {
+			size_t const* const elem = &mesh->elems[incidence[e] * kind];
+
+			for (size_t j = 0; j < kind; j++) {
+				if (marker[elem[j]] == i + 1) {
+					continue;
+				}
+
+				marker[elem[j]] = i + 1;
+				deg++;
+			}
+		}
+
+		graph->offsets[i + 1] = graph->offsets[i] + deg;
+	}
+
+	// second pass: actually fill in & sort neighbours
+	// markers from the first pass can be reused by shifting them by n
+
+	graph->neighbours = state->alloc(graph->offsets[n] * sizeof *graph->neighbours);
+
+	if (graph->neighbours == NULL) {
+		state->free(graph->offsets);
+		goto err_neighbours_alloc;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		size_t* const neighbours = &graph->neighbours[graph->offsets[i]];
+		size_t deg = 0;
+
+		neighbours[deg++] = i;
+		marker[i] = n + i + 1;
+
+		for (size_t e = incidence_offsets[i]; e < incidence_offsets[i + 1]; e++) {
+			size_t const* const elem = &mesh->elems[incidence[e] * kind];
+
+			for (size_t j = 0; j < kind; j++) {
+				if (marker[elem[j]] == n + i + 1) {
+					continue;
+				}
+
+				marker[elem[j]] = n + i + 1;
+				neighbours[deg++] = elem[j];
+			}
+		}
+
+		qsort(neighbours, deg, sizeof *neighbours, cmp_node);
+	}
+
+	// success
+
+	rv = 0;
+
+err_neighbours_alloc:
+err_offsets_alloc:
+
+	state->free(marker);
+
+err_marker_alloc:
+
+	state->free(incidence);
+
+err_incidence_alloc:
+
+	state->free(incidence_offsets);
+
+err_incidence_offsets_alloc:
+
+	return rv;
+}
+
+int bfm_graph_create_expand(bfm_graph_t* graph, bfm_graph_t* src, size_t dim) {
+	bfm_state_t* const state = src->state;
+
+	memset(graph, 0, sizeof *graph);
+	graph->state = state;
+
+	size_t const n = src->n * dim;
+	graph->n = n;
+
+	graph->offsets = state->alloc((n + 1) * sizeof *graph->offsets);
+
+	if (graph->offsets == NULL) {
+		return -1;
+	}
+
+	graph->neighbours = state->alloc(src->offsets[src->n] * dim * dim * sizeof *graph->neighbours);
+
+	if (graph->neighbours == NULL) {
+		state->free(graph->offsets);
+		return -1;
+	}
+
+	// node i*dim+p of the expanded graph is adjacent to nodes j*dim+q for every neighbour j of i and every q
+	// since neighbours of i are sorted, this keeps the expanded neighbours sorted too
+
+	size_t cur = 0;
+
+	for (size_t i = 0; i < src->n; i++) {
+		for (size_t p = 0; p < dim; p++) {
+			graph->offsets[i * dim + p] = cur;
+
+			for (size_t j = src->offsets[i]; j < src->offsets[i + 1]; j++) {
+				for (size_t q = 0; q < dim; q++) {
+					graph->neighbours[cur++] = src->neighbours[j] * dim + q;
+				}
+			}
+		}
+	}
+
+	graph->offsets[n] = cur;
+
+	return 0;
+}
+
+int bfm_graph_create_matrix(bfm_graph_t* graph, bfm_state_t* state, bfm_matrix_t* matrix) {
+	memset(graph, 0, sizeof *graph);
+	graph->state = state;
+
+	size_t const n = matrix->m;
+	graph->n = n;
+
+	graph->offsets = state->alloc((n + 1) * sizeof *graph->offsets);
+
+	if (graph->offsets == NULL) {
+		return -1;
+	}
+
+	// sparse matrices already carry their pattern, which is sorted by column
+
+	if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		bfm_matrix_csr_t* const csr = &matrix->csr;
+
+		graph->neighbours = state->alloc(csr->nnz * sizeof *graph->neighbours);
+
+		if (graph->neighbours == NULL) {
+			state->free(graph->offsets);
+			return -1;
+		}
+
+		memcpy(graph->offsets, csr->offsets, (n + 1) * sizeof *graph->offsets);
+		memcpy(graph->neighbours, csr->cols, csr->nnz * sizeof *graph->neighbours);
+
+		return 0;
+	}
+
+	// otherwise, count the non-zero entries of each row first, then fill them in
+
+	graph->offsets[0] = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		size_t deg = 0;
+
+		for (size_t j = 0; j < n; j++) {
+			deg += !!bfm_matrix_get(matrix, i, j);
+		}
+
+		graph->offsets[i + 1] = graph->offsets[i] + deg;
+	}
+
+	graph->neighbours = state->alloc(graph->offsets[n] * sizeof *graph->neighbours);
+
+	if (graph->neighbours == NULL) {
+		state->free(graph->offsets);
+		return -1;
+	}
+
+	size_t cur = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < n; j++) {
+			if (bfm_matrix_get(matrix, i, j)) {
+				graph->neighbours[cur++] = j;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int bfm_graph_destroy(bfm_graph_t* graph) {
+	bfm_state_t* const state = graph->state;
+
+	state->free(graph->offsets);
+	state->free(graph->neighbours);
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 #include <string.h>
 
 #include <bfm/instance.h>
+#include <bfm/system.h>
 
 int bfm_instance_create(bfm_instance_t* instance, bfm_state_t* state, bfm_obj_t* obj) {
 	memset(instance, 0, sizeof *instance);
@@ -35,6 +36,16 @@ int bfm_instance_destroy(bfm_instance_t* instance) {
 		state->free(instance->conditions);
 	}
 
+	if (instance->case_effects) {
+		state->free(instance->case_effects);
+	}
+
+	if (instance->sweep_effects) {
+		state->free(instance->sweep_effects);
+	}
+
+	bfm_instance_release_system(instance);
+
 	return 0;
 }
 
@@ -71,3 +82,17 @@ int bfm_instance_add_condition(bfm_instance_t* instance, bfm_condition_t* condit
 
 	return 0;
 }
+
+int bfm_instance_release_system(bfm_instance_t* instance) {
+	bfm_state_t* const state = instance->state;
+
+	if (!instance->system) {
+		return 0;
+	}
+
+	bfm_system_destroy(instance->system);
+	state->free(instance->system);
+	instance->system = NULL;
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include <pthread.h>
+
+#include <bfm/kernel.h>
+#include <bfm/math.h>
+
+// baseline kernels, which every CPU of the architecture can run
+// these are SSE2 on x86-64 & NEON on AArch64, which have 16 & 32 vector registers respectively
+// elsewhere, the compiler lowers the vectors to whatever it can
+
+#define KERNEL(name) name##_base
+#define KERNEL_TARGET
+#define VEC_LEN 2
+
+#if defined(__aarch64__)
+# define GEMM_MV 4
+# define GEMM_NR 4
+#else
+# define GEMM_MV 2
+# define GEMM_NR 4
+#endif
+
+#include "kernel_impl.h"
+
+// x86 kernels for wider vectors, compiled for their instruction sets regardless of the ones enabled for the rest of the library
+// AVX2 has 16 vector registers & AVX-512 has 32, which bounds how many accumulators the GEMM micro-tiles can keep
+
+#if defined(__x86_64__) || defined(__i386__)
+# define KERNEL_X86
+
+# define KERNEL(name) name##_avx2
+# define KERNEL_TARGET __attribute__((target("avx2,fma")))
+# define VEC_LEN 4
+# define GEMM_MV 3
+# define GEMM_NR 4
+
+# include "kernel_impl.h"
+
+# define KERNEL(name) name##_avx512
+# define KERNEL_TARGET __attribute__((target("avx512f")))
+# define VEC_LEN 8
+# define GEMM_MV 3
+# define GEMM_NR 8
+
+# include "kernel_impl.h"
+#endif
+
+// dispatch
+// the kernels are picked once, the first time any of them is called
+
+typedef struct {
+	void (*daxpy)(size_t n, double alpha, double const* x, double* y);
+	double (*ddot)(size_t n, double const* x, double const* y);
+	void (*dgemm_sub)(size_t m, size_t n, size_t k, double const* a, size_t lda, double const* b, size_t b_l, size_t b_j, double* c, size_t ldc);
+} kernels_t;
+
+static kernels_t kernels = {
+	.daxpy = daxpy_base,
+	.ddot = ddot_base,
+	.dgemm_sub = dgemm_sub_base,
+};
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static void kernels_pick(void) {
+#if defined(KERNEL_X86)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f")) {
+		kernels = (kernels_t) {
+			.daxpy = daxpy_avx512,
+			.ddot = ddot_avx512,
+			.dgemm_sub = dgemm_sub_avx512,
+		};
+	}
+
+	else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		kernels = (kernels_t) {
+			.daxpy = daxpy_avx2,
+			.ddot = ddot_avx2,
+			.dgemm_sub = dgemm_sub_avx2,
+		};
+	}
+#endif
+}
+
+void bfm_kernel_daxpy(size_t n, double alpha, double const* x, double* y) {
+	pthread_once(&kernels_once, kernels_pick);
+	kernels.daxpy(n, alpha, x, y);
+}
+
+double bfm_kernel_ddot(size_t n, double const* x, double const* y) {
+	pthread_once(&kernels_once, kernels_pick);
+	return kernels.ddot(n, x, y);
+}
+
+void bfm_kernel_dgemm_sub(size_t m, size_t n, size_t k, double const* a, size_t lda, double const* b, size_t b_l, size_t b_j, double* c, size_t ldc) {
+	pthread_once(&kernels_once, kernels_pick);
+	kernels.dgemm_sub(m, n, k, a, lda, b, b_l, b_j, c, ldc);
+}
@@ -0,0 +1,158 @@
+// vector kernels for one instruction set, included once per instruction set by kernel.c
+// the including file defines:
+// - KERNEL(name), the name of a kernel for this instruction set
+// - KERNEL_TARGET, the attributes needed to compile for it
+// - VEC_LEN, the number of doubles in a vector
+// - GEMM_MV & GEMM_NR, the shape of the micro-tiles of C (GEMM_MV vectors by GEMM_NR columns), which are kept in registers over the whole inner dimension
+
+// vectors are only aligned on doubles, so they can be loaded & stored from anywhere in an array of doubles
+
+typedef double KERNEL(vec_t) __attribute__((vector_size(VEC_LEN * sizeof(double)), aligned(sizeof(double)), may_alias));
+
+#define VEC KERNEL(vec_t)
+#define VEC_AT(x) (*(VEC*) (x))
+#define VEC_AT_CONST(x) (*(VEC const*) (x))
+
+KERNEL_TARGET static void KERNEL(daxpy)(size_t n, double alpha, double const* x, double* y) {
+	size_t i = 0;
+
+	for (; i + 4 * VEC_LEN <= n; i += 4 * VEC_LEN) {
+#pragma GCC unroll 4
+		for (size_t u = 0; u < 4; u++) {
+			VEC_AT(y + i + u * VEC_LEN) += alpha * VEC_AT_CONST(x + i + u * VEC_LEN);
+		}
+	}
+
+	for (; i + VEC_LEN <= n; i += VEC_LEN) {
+		VEC_AT(y + i) += alpha * VEC_AT_CONST(x + i);
+	}
+
+	for (; i < n; i++) {
+		y[i] += alpha * x[i];
+	}
+}
+
+// four independent accumulators, so that consecutive additions don't wait on each other
+
+KERNEL_TARGET static double KERNEL(ddot)(size_t n, double const* x, double const* y) {
+	VEC acc[4] = { { 0 }, { 0 }, { 0 }, { 0 } };
+	size_t i = 0;
+
+	for (; i + 4 * VEC_LEN <= n; i += 4 * VEC_LEN) {
+#pragma GCC unroll 4
+		for (size_t u = 0; u < 4; u++) {
+			acc[u] += VEC_AT_CONST(x + i + u * VEC_LEN) * VEC_AT_CONST(y + i + u * VEC_LEN);
+		}
+	}
+
+	for (; i + VEC_LEN <= n; i += VEC_LEN) {
+		acc[0] += VEC_AT_CONST(x + i) * VEC_AT_CONST(y + i);
+	}
+
+	VEC const sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+	double dot = 0;
+
+	for (size_t l = 0; l < VEC_LEN; l++) {
+		dot += sum[l];
+	}
+
+	for (; i < n; i++) {
+		dot += x[i] * y[i];
+	}
+
+	return dot;
+}
+
+// C -= AB on a tile of mv vectors by nr columns of C
+// this is always inlined, so that it's specialized for each (constant) tile shape it's called with & its accumulators stay in registers
+
+KERNEL_TARGET static inline __attribute__((always_inline)) void KERNEL(dgemm_tile)(size_t mv, size_t nr, size_t k, double const* a, size_t lda, double const* b, size_t b_l, size_t b_j, double* c, size_t ldc) {
+	VEC acc[GEMM_MV][GEMM_NR] = { { { 0 } } };
+
+	for (size_t l = 0; l < k; l++) {
+		double const* const a_l = a + l * lda;
+		double const* const b_row = b + l * b_l;
+
+		VEC a_v[GEMM_MV];
+
+#pragma GCC unroll 4
+		for (size_t v = 0; v < mv; v++) {
+			a_v[v] = VEC_AT_CONST(a_l + v * VEC_LEN);
+		}
+
+#pragma GCC unroll 16
+		for (size_t j = 0; j < nr; j++) {
+			double const b_lj = b_row[j * b_j];
+
+#pragma GCC unroll 4
+			for (size_t v = 0; v < mv; v++) {
+				acc[v][j] += a_v[v] * b_lj;
+			}
+		}
+	}
+
+#pragma GCC unroll 16
+	for (size_t j = 0; j < nr; j++) {
+#pragma GCC unroll 4
+		for (size_t v = 0; v < mv; v++) {
+			VEC_AT(c + j * ldc + v * VEC_LEN) -= acc[v][j];
+		}
+	}
+}
+
+// C is gone through by micro-tiles of GEMM_MV vectors by GEMM_NR columns, then single vectors by GEMM_NR columns for the rows left
+// the last few rows which don't fill up a vector are done entry by entry
+
+KERNEL_TARGET static void KERNEL(dgemm_sub)(size_t m, size_t n, size_t k, double const* a, size_t lda, double const* b, size_t b_l, size_t b_j, double* c, size_t ldc) {
+	size_t const mr = GEMM_MV * VEC_LEN;
+
+	for (size_t j = 0; j < n; j += GEMM_NR) {
+		size_t const nr = BFM_MIN(GEMM_NR, n - j);
+		double const* const b_col = b + j * b_j;
+		double* const c_col = c + j * ldc;
+
+		size_t i = 0;
+
+		if (nr == GEMM_NR) {
+			for (; i + mr <= m; i += mr) {
+				KERNEL(dgemm_tile)(GEMM_MV, GEMM_NR, k, a + i, lda, b_col, b_l, b_j, c_col + i, ldc);
+			}
+
+			for (; i + VEC_LEN <= m; i += VEC_LEN) {
+				KERNEL(dgemm_tile)(1, GEMM_NR, k, a + i, lda, b_col, b_l, b_j, c_col + i, ldc);
+			}
+		}
+
+		else {
+			for (; i + mr <= m; i += mr) {
+				KERNEL(dgemm_tile)(GEMM_MV, nr, k, a + i, lda, b_col, b_l, b_j, c_col + i, ldc);
+			}
+
+			for (; i + VEC_LEN <= m; i += VEC_LEN) {
+				KERNEL(dgemm_tile)(1, nr, k, a + i, lda, b_col, b_l, b_j, c_col + i, ldc);
+			}
+		}
+
+		for (; i < m; i++) {
+			for (size_t jj = 0; jj < nr; jj++) {
+				double acc = 0;
+
+				for (size_t l = 0; l < k; l++) {
+					acc += a[i + l * lda] * b_col[l * b_l + jj * b_j];
+				}
+
+				c_col[i + jj * ldc] -= acc;
+			}
+		}
+	}
+}
+
+#undef VEC
+#undef VEC_AT
+#undef VEC_AT_CONST
+
+#undef KERNEL
+#undef KERNEL_TARGET
+#undef VEC_LEN
+#undef GEMM_MV
+#undef GEMM_NR
@@ -1,13 +1,42 @@
 #include <string.h>
 
 #include <bfm/matrix.h>
+#include <bfm/team.h>
 
 #if defined(WITH_BLAS)
 # include <cblas.h>
+#else
+# include <bfm/kernel.h>
+#endif
+
+#if defined(WITH_LAPACKE)
+# include <lapacke.h>
+#endif
+
+// vector kernels, from BLAS if available and from our own otherwise
+
+static void axpy(size_t n, double alpha, double const* x, double* y) {
+#if defined(WITH_BLAS)
+	cblas_daxpy(n, alpha, x, 1, y, 1);
+#else
+	bfm_kernel_daxpy(n, alpha, x, y);
 #endif
+}
+
+static double dot(size_t n, double const* x, double const* y) {
+#if defined(WITH_BLAS)
+	return cblas_ddot(n, x, 1, y, 1);
+#else
+	return bfm_kernel_ddot(n, x, y);
+#endif
+}
 
 // full matrix
 
+static inline size_t full_idx(bfm_matrix_t* matrix, size_t i, size_t j) {
+	return matrix->major == BFM_MATRIX_MAJOR_ROW ? i * matrix->m + j : i + j * matrix->m;
+}
+
 static int matrix_full_copy(bfm_matrix_t* matrix, bfm_matrix_t* src) {
 	size_t const size = src->m * src->m * sizeof *matrix->full.data;
 	memcpy(matrix->full.data, src->full.data, size);
@@ -27,9 +56,7 @@ static double matrix_full_get(bfm_matrix_t* matrix, size_t i, size_t j) {
 		return BFM_NAN;
 	}
 
-	int const idx = matrix->major == BFM_MATRIX_MAJOR_ROW ? i * matrix->m + j : i + j * matrix->m;
-
-	return matrix->full.data[idx];
+	return matrix->full.data[full_idx(matrix, i, j)];
 }
 
 static int matrix_full_set(bfm_matrix_t* matrix, size_t i, size_t j, double val) {
@@ -37,9 +64,7 @@ static int matrix_full_set(bfm_matrix_t* matrix, size_t i, size_t j, double val)
 		return -1;
 	}
 
-	int const idx = matrix->major == BFM_MATRIX_MAJOR_ROW ? i * matrix->m + j : i + j * matrix->m;
-
-	matrix->full.data[idx] = val;
+	matrix->full.data[full_idx(matrix, i, j)] = val;
 	return 0;
 }
 
@@ -48,9 +73,7 @@ static int matrix_full_add(bfm_matrix_t* matrix, size_t i, size_t j, double val)
 		return -1;
 	}
 
-	int const idx = matrix->major == BFM_MATRIX_MAJOR_ROW ? i * matrix->m + j : i + j * matrix->m;
-
-	matrix->full.data[idx] += val;
+	matrix->full.data[full_idx(matrix, i, j)] += val;
 	return 0;
 }
 
@@ -70,15 +93,19 @@ static size_t matrix_full_bandwidth(bfm_matrix_t* matrix) {
 	return k;
 }
 
+// the factorization & solves go along rows or columns of the matrix depending on its major, so that the vector kernels always work on contiguous entries
+// the multiplier of each update is the same either way, so both give the same result
+
 static int matrix_full_lu(bfm_matrix_t* matrix) {
-	size_t const size = matrix->m;
+	size_t const m = matrix->m;
+	double* const data = matrix->full.data;
 
-	for (size_t pivot_i = 0; pivot_i < size - 1; pivot_i++) {
+	for (size_t pivot_i = 0; pivot_i + 1 < m; pivot_i++) {
 		// TODO handle error case and non square matrix
 
-		double const pivot = matrix_full_get(matrix, pivot_i, pivot_i);
+		double const pivot = data[full_idx(matrix, pivot_i, pivot_i)];
 
-		if (pivot != pivot) {
+		if (BFM_IS_NAN(pivot)) {
 			return -1;
 		}
 
@@ -86,34 +113,33 @@ static int matrix_full_lu(bfm_matrix_t* matrix) {
 			return -1;
 		}
 
-		for (size_t i = pivot_i + 1; i < size; i++) {
-			double row_val = matrix_full_get(matrix, i, pivot_i);
+		size_t const len = m - pivot_i - 1;
 
-			if (BFM_IS_NAN(row_val)) {
-				return -1;
-			}
+		if (matrix->major == BFM_MATRIX_MAJOR_ROW) {
+			double const* const pivot_row = data + full_idx(matrix, pivot_i, pivot_i + 1);
 
-			double factor = row_val / pivot;
+			for (size_t i = pivot_i + 1; i < m; i++) {
+				double* const row = data + full_idx(matrix, i, pivot_i);
+				double const factor = row[0] / pivot;
 
-			// set pivot to one
+				// A[i][j] -= A[i][k] * A[k][j]
 
-			if (matrix_full_set(matrix, i, pivot_i, factor) < 0) {
-				return -1;
+				row[0] = factor;
+				axpy(len, -factor, pivot_row, row + 1);
 			}
+		}
 
-#if defined(WITH_BLAS)
-			cblas_daxpy(size - pivot_i - 1, -factor, matrix->full.data + pivot_i * size + pivot_i + 1, 1, matrix->full.data + i * size + pivot_i + 1, 1);
-#else
-			for (size_t j = pivot_i + 1; j < size; j++) {
-				double const val_row_pivot = matrix_full_get(matrix, pivot_i, j);
+		else {
+			double* const pivot_col = data + full_idx(matrix, pivot_i + 1, pivot_i);
 
-				// A[i][j] -= A[i][k] * A[k][j]
+			for (size_t i = 0; i < len; i++) {
+				pivot_col[i] /= pivot;
+			}
 
-				if (matrix_full_add(matrix, i, j, -factor * val_row_pivot) < 0) {
-					return -1;
-				}
+			for (size_t j = pivot_i + 1; j < m; j++) {
+				double* const col = data + full_idx(matrix, pivot_i, j);
+				axpy(len, -col[0], pivot_col, col + 1);
 			}
-#endif
 		}
 	}
 
@@ -122,24 +148,23 @@ static int matrix_full_lu(bfm_matrix_t* matrix) {
 
 static int matrix_full_lu_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
 	double* const y = vec->data;
-	double const m = matrix->m;
+	size_t const m = matrix->m;
+	double const* const data = matrix->full.data;
 
 	// forward substitution Lx = y
 
 #if defined(WITH_BLAS)
 	CBLAS_LAYOUT const layout = matrix->major == BFM_MATRIX_MAJOR_ROW ? CblasRowMajor : CblasColMajor;
 
-	cblas_dtrsv(layout, CblasLower, CblasNoTrans, CblasUnit, m, matrix->full.data, m, y, 1);
+	cblas_dtrsv(layout, CblasLower, CblasNoTrans, CblasUnit, m, data, m, y, 1);
 #else
-	for (size_t i = 0; i < matrix->m; i++) {
-		for (size_t j = 0; j < i; j++) {
-			double const val = matrix_full_get(matrix, i, j);
-
-			if (BFM_IS_NAN(val)) {
-				return -1;
-			}
+	for (size_t i = 0; i < m; i++) {
+		if (matrix->major == BFM_MATRIX_MAJOR_ROW) {
+			y[i] -= dot(i, data + full_idx(matrix, i, 0), y);
+		}
 
-			y[i] -= val * y[j];
+		else {
+			axpy(m - i - 1, -y[i], data + full_idx(matrix, i + 1, i), y + i + 1);
 		}
 	}
 #endif
@@ -147,40 +172,91 @@ static int matrix_full_lu_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
 	// backward substitution Ux = L^-1 @ y
 
 #if defined(WITH_BLAS)
-	cblas_dtrsv(layout, CblasUpper, CblasNoTrans, CblasNonUnit, m, matrix->full.data, m, y, 1);
+	cblas_dtrsv(layout, CblasUpper, CblasNoTrans, CblasNonUnit, m, data, m, y, 1);
 #else
-	for (ssize_t i = m - 1; i >= 0; i--) {
-		for (size_t j = i + 1; j < matrix->m; j++) {
-			double const val = matrix_full_get(matrix, i, j);
-
-			if (BFM_IS_NAN(val)) {
-				return -1;
-			}
-
-			y[i] -= val * y[j];
+	for (size_t i = m; i-- > 0;) {
+		if (matrix->major == BFM_MATRIX_MAJOR_ROW) {
+			y[i] -= dot(m - i - 1, data + full_idx(matrix, i, i + 1), y + i + 1);
 		}
 
-		double const pivot = matrix_full_get(matrix, i, i);
+		double const pivot = data[full_idx(matrix, i, i)];
 
 		if (BFM_IS_NAN(pivot)) {
 			return -1;
 		}
 
 		y[i] /= pivot;
+
+		if (matrix->major != BFM_MATRIX_MAJOR_ROW) {
+			axpy(i, -y[i], data + full_idx(matrix, 0, i), y);
+		}
 	}
 #endif
 
 	return 0;
 }
 
+// y is an mxr row-major block of right-hand sides, so each row of the factor only needs to be read once for all of them
+
+static int matrix_full_lu_solve_multi(bfm_matrix_t* matrix, size_t r, double* y) {
+	size_t const m = matrix->m;
+	double const* const data = matrix->full.data;
+
+	// forward substitution LX = Y
+
+	for (size_t i = 0; i < m; i++) {
+		for (size_t j = 0; j < i; j++) {
+			double const val = data[full_idx(matrix, i, j)];
+
+			for (size_t c = 0; c < r; c++) {
+				y[i * r + c] -= val * y[j * r + c];
+			}
+		}
+	}
+
+	// backward substitution UX = L^-1 @ Y
+
+	for (size_t i = m; i-- > 0;) {
+		for (size_t j = i + 1; j < m; j++) {
+			double const val = data[full_idx(matrix, i, j)];
+
+			for (size_t c = 0; c < r; c++) {
+				y[i * r + c] -= val * y[j * r + c];
+			}
+		}
+
+		double const pivot = data[full_idx(matrix, i, i)];
+
+		if (BFM_IS_NAN(pivot) || !pivot) {
+			return -1;
+		}
+
+		for (size_t c = 0; c < r; c++) {
+			y[i * r + c] /= pivot;
+		}
+	}
+
+	return 0;
+}
+
 // band matrix routines
+// entries are stored in LAPACK's general band layout (see bfm_matrix_band_t), so columns of the band are contiguous
+// the factorization & solves are thus column-oriented: each step is an axpy down a column, as in LAPACK's unblocked dgbtf2
+
+static inline size_t band_ld(size_t k) {
+	return 3 * k + 1;
+}
+
+static inline size_t band_idx(size_t k, size_t i, size_t j) {
+	return j * band_ld(k) + 2 * k + i - j;
+}
 
 static int matrix_band_copy(bfm_matrix_t* matrix, bfm_matrix_t* src) {
 	if (matrix->band.k != src->band.k) {
 		return -1;
 	}
 
-	size_t const size = src->m * (src->band.k * 2 + 1) * sizeof *src->band.data;
+	size_t const size = src->m * band_ld(src->band.k) * sizeof *src->band.data;
 	memcpy(matrix->band.data, src->band.data, size);
 
 	return 0;
@@ -190,6 +266,10 @@ static int matrix_band_destroy(bfm_matrix_t* matrix) {
 	bfm_state_t* const state = matrix->state;
 	state->free(matrix->band.data);
 
+	if (matrix->band.pivots != NULL) {
+		state->free(matrix->band.pivots);
+	}
+
 	return 0;
 }
 
@@ -205,9 +285,7 @@ static double matrix_band_get(bfm_matrix_t* matrix, size_t i, size_t j) {
 		return 0;
 	}
 
-	size_t const idx = matrix->major == BFM_MATRIX_MAJOR_ROW ? j + i * 2 * k : i + j * 2 * k;
-
-	return matrix->band.data[idx];
+	return matrix->band.data[band_idx(k, i, j)];
 }
 
 static int matrix_band_set(bfm_matrix_t* matrix, size_t i, size_t j, double value) {
@@ -222,9 +300,7 @@ static int matrix_band_set(bfm_matrix_t* matrix, size_t i, size_t j, double valu
 		return fabs(value) < BFM_PIVOT_EPS ? 0 : -1;
 	}
 
-	size_t const idx = matrix->major == BFM_MATRIX_MAJOR_ROW ? j + i * 2 * k : i + j * 2 * k;
-
-	matrix->band.data[idx] = value;
+	matrix->band.data[band_idx(k, i, j)] = value;
 	return 0;
 }
 
@@ -240,9 +316,7 @@ static int matrix_band_add(bfm_matrix_t* matrix, size_t i, size_t j, double valu
 		return fabs(value) < BFM_PIVOT_EPS ? 0 : -1;
 	}
 
-	size_t const idx = matrix->major == BFM_MATRIX_MAJOR_ROW ? j + i * 2 * k : i + j * 2 * k;
-
-	matrix->band.data[idx] += value;
+	matrix->band.data[band_idx(k, i, j)] += value;
 	return 0;
 }
 
@@ -250,252 +324,1518 @@ static size_t matrix_band_bandwidth(bfm_matrix_t* matrix) {
 	return matrix->band.k;
 }
 
-static int matrix_band_lu(bfm_matrix_t* matrix) {
-	size_t const m = matrix->m;
-	size_t const k = matrix->band.k;
+#if defined(WITH_LAPACKE)
+// LAPACK routines for band matrices
+// these are blocked & tuned by the vendor, but pivot, so the factorization doesn't quite have the same shape as ours and must be solved through LAPACK too
+// right-hand side blocks are row-major here but column-major in LAPACK, so they're transposed around the LAPACK calls
 
-	for (size_t pivot_i = 0; pivot_i < m - 1; pivot_i++) {
-		double const pivot = matrix_band_get(matrix, pivot_i, pivot_i);
+_Static_assert(sizeof(lapack_int) == sizeof(int), "bfm_matrix_band_t::pivots assumes LAPACK uses 32-bit integers");
 
-		if (BFM_IS_NAN(pivot)) {
-			return -1;
-		}
+static int band_alloc_pivots(bfm_matrix_t* matrix) {
+	if (matrix->band.pivots != NULL) {
+		return 0;
+	}
 
-		if (fabs(pivot) < BFM_PIVOT_EPS) {
-			return -1;
-		}
+	matrix->band.pivots = matrix->state->alloc(matrix->m * sizeof *matrix->band.pivots);
 
-		size_t const len = BFM_MIN(pivot_i + k + 1, m);
+	if (matrix->band.pivots == NULL) {
+		return -1;
+	}
 
-		for (size_t i = pivot_i + 1; i < len; i++) {
-			double val_below_pivot = matrix_band_get(matrix, i, pivot_i);
+	return 0;
+}
 
-			if (BFM_IS_NAN(val_below_pivot)) {
-				return -1;
-			}
+static int lapacke_solve_multi(bfm_matrix_t* matrix, size_t r, double* y, int (*solve)(bfm_matrix_t* matrix, size_t r, double* b)) {
+	bfm_state_t* const state = matrix->state;
+	size_t const m = matrix->m;
 
-			val_below_pivot /= pivot;
+	if (r == 1) {
+		return solve(matrix, 1, y);
+	}
 
-			if (matrix_band_set(matrix, i, pivot_i, val_below_pivot) < 0) {
-				return -1;
-			}
+	double* const b = state->alloc(m * r * sizeof *b);
 
-#if defined(WITH_BLAS)
-			cblas_daxpy(len - pivot_i - 1, -val_below_pivot, matrix->band.data + pivot_i * (2 * k + 1) + pivot_i + 1, 1, matrix->band.data + i * (2 * k + 1) + pivot_i + 1, 1);
-#else
-			for (size_t j = pivot_i + 1; j < len; j++) {
-				double const val = matrix_band_get(matrix, pivot_i, j);
+	if (b == NULL) {
+		return -1;
+	}
 
-				if (BFM_IS_NAN(val)) {
-					return -1;
-				}
+	for (size_t i = 0; i < m; i++) {
+		for (size_t c = 0; c < r; c++) {
+			b[c * m + i] = y[i * r + c];
+		}
+	}
 
-				if (matrix_band_add(matrix, i, j, -val_below_pivot * val) < 0) {
-					return -1;
-				}
-			}
-#endif
+	int const rv = solve(matrix, r, b);
+
+	for (size_t i = 0; rv == 0 && i < m; i++) {
+		for (size_t c = 0; c < r; c++) {
+			y[i * r + c] = b[c * m + i];
 		}
 	}
 
-	return 0;
+	state->free(b);
+	return rv;
 }
 
-__attribute__((unused)) static int matrix_band_cholesky(bfm_matrix_t* matrix) {
+static int matrix_band_lapacke_lu(bfm_matrix_t* matrix) {
 	size_t const m = matrix->m;
+	size_t const k = matrix->band.k;
 
-	for (size_t i = 0; i < m; i++) {
-		size_t const len = BFM_MAX(0, matrix->band.k - i);
-
-		for (size_t j = len; j < i; j++) {
-			double s = 0;
+	if (band_alloc_pivots(matrix) < 0) {
+		return -1;
+	}
 
-			for (size_t k = len; k < j; k++) {
-				double const a = matrix_band_get(matrix, i, k);
-				double const b = matrix_band_get(matrix, j, k);
+	if (LAPACKE_dgbtrf(LAPACK_COL_MAJOR, m, m, k, k, matrix->band.data, band_ld(k), matrix->band.pivots) != 0) {
+		return -1;
+	}
 
-				if (BFM_IS_NAN(a) || BFM_IS_NAN(b)) {
-					return -1;
-				}
+	return 0;
+}
 
-				s += a * b;
-			}
+static int band_lapacke_trs(bfm_matrix_t* matrix, size_t r, double* b) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->band.k;
 
-			double const val = matrix_band_get(matrix, i, j);
+	if (matrix->band.pivots == NULL) {
+		return -1;
+	}
 
-			if (BFM_IS_NAN(val)) {
-				return -1;
-			}
+	if (LAPACKE_dgbtrs(LAPACK_COL_MAJOR, 'N', m, k, k, r, matrix->band.data, band_ld(k), matrix->band.pivots, b, m) != 0) {
+		return -1;
+	}
 
-			if (i == j && matrix_band_set(matrix, i, j, sqrt(val - s)) < 0) {
-				return -1;
-			}
+	return 0;
+}
 
-			else {
-				double const pivot = matrix_band_get(matrix, j, j);
+static int matrix_band_lapacke_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->band.k;
 
-				if (BFM_IS_NAN(val)) {
-					return -1;
-				}
+	if (band_alloc_pivots(matrix) < 0) {
+		return -1;
+	}
 
-				if (matrix_band_set(matrix, i, j, 1 / pivot * (val - s)) < 0) {
-					return -1;
-				}
-			}
-		}
+	if (LAPACKE_dgbsv(LAPACK_COL_MAJOR, m, k, k, 1, matrix->band.data, band_ld(k), matrix->band.pivots, vec->data, m) != 0) {
+		return -1;
 	}
 
 	return 0;
 }
+#endif
 
-static int matrix_band_lu_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
-	size_t const m = matrix->m;
-	size_t const k = matrix->band.k;
+#if !defined(WITH_LAPACKE)
+// the band factorizations & solves are run by teams of threads (see bfm/team.h), which all share a band_team_t
 
-	// forward substitution
+#define BAND_NB 32
+#define BAND_NB_MIN 8 // narrower bands don't leave room for panels wide enough to be worth it
+#define BAND_GROUP 4  // slices of the trailing update per call to update, see factorize_task
 
-	for (ssize_t pivot_i = 0; pivot_i < (ssize_t) m; pivot_i++) {
-		ssize_t const len = BFM_MAX(pivot_i - (ssize_t) k, 0);
+typedef struct band_team_t band_team_t;
 
-#if defined(WITH_BLAS)
-		vec->data[pivot_i] -= cblas_ddot(pivot_i - len, matrix->band.data + pivot_i * (2 * k + 1) + len, 1, vec->data + len, 1);
-#else
-		for (ssize_t i = len; i < pivot_i; i++) {
-			double const val = matrix_band_get(matrix, pivot_i, i);
+// a panel of the blocked factorizations, along with the extents of its trailing update
 
-			if (BFM_IS_NAN(val)) {
-				return -1;
-			}
+typedef struct {
+	size_t p; // first column of the panel
+	size_t b; // width of the panel
 
-			vec->data[pivot_i] -= val * vec->data[i];
-		}
-#endif
-	}
+	size_t n;   // number of columns right of the panel its trailing update can reach
+	size_t mid; // rows of the panel up to mid - 1 are entirely within the band, see band_lu_prepare
+	size_t end; // rows of the trailing update end at row end - 1
 
-	// backward substitution
+	double* work;
+	double* work_l;
+} band_panel_t;
 
-	for (ssize_t pivot_i = m - 1; pivot_i >= 0; pivot_i--) {
-		ssize_t const len = BFM_MIN(pivot_i + k + 1, m);
+struct band_team_t {
+	bfm_matrix_t* matrix;
+	size_t k;
 
-#if defined(WITH_BLAS)
-		vec->data[pivot_i] -= cblas_ddot(len - pivot_i - 1, matrix->band.data + pivot_i * (2 * k + 1) + pivot_i + 1, 1, vec->data + pivot_i + 1, 1);
-#else
-		for (ssize_t i = pivot_i + 1; i < len; i++) {
-			double const val = matrix_band_get(matrix, pivot_i, i);
+	// factorizations
+	// panels are double-buffered, as the next one is factorized while the trailing update of the current one is still going on
 
-			if (BFM_IS_NAN(val)) {
-				return -1;
-			}
+	int (*prepare)(band_team_t* team, band_panel_t* panel, size_t p);
+	void (*update)(band_team_t* team, band_panel_t const* panel, size_t from, size_t to);
 
-			vec->data[pivot_i] -= vec->data[i] * val;
-		}
-#endif
+	band_panel_t panels[2];
+	bool failed;
 
-		double const pivot = matrix_band_get(matrix, pivot_i, pivot_i);
+	// solves
+	// y is an mxr row-major block of right-hand sides, and the factor is accessed column by column, diagonal entry p being at diag[p * stride]
 
-		if (BFM_IS_NAN(pivot) || !pivot) {
-			return -1;
-		}
+	size_t r;
+	double* y;
 
-		vec->data[pivot_i] /= pivot;
-	}
+	double const* diag;
+	size_t stride;
 
-	return 0;
-}
+	bool scale; // divide by the diagonal between both substitutions, for U^T D U factorizations
 
-// generic matrix routines
+	int (*upper_block)(band_team_t* team, size_t q, size_t e);
+	void (*upper_rows)(band_team_t* team, size_t q, size_t e, size_t from, size_t to);
+};
 
-int bfm_matrix_copy(bfm_matrix_t* matrix, bfm_matrix_t* src) {
-	if (matrix->m != src->m) {
-		return -1;
-	}
+// rows from to to-1 left for a worker to go through, while the first worker is busy with the next block if there are others
 
-	// bespoke copying functions
-	// these are here to make copying faster than the generic method
+static void team_split(bfm_team_worker_t* worker, size_t from, size_t to, size_t* part_from, size_t* part_to) {
+	size_t const n_threads = worker->team->n_threads;
 
-	if (matrix->kind == BFM_MATRIX_KIND_FULL && src->kind == BFM_MATRIX_KIND_FULL) {
-		return matrix_full_copy(matrix, src);
+	if (n_threads == 1) {
+		*part_from = from;
+		*part_to = to;
+
+		return;
 	}
 
-	if (matrix->kind == BFM_MATRIX_KIND_BAND && src->kind == BFM_MATRIX_KIND_BAND) {
-		return matrix_band_copy(matrix, src);
+	if (worker->id == 0) {
+		*part_from = *part_to = to;
+		return;
 	}
 
-	// generic method for copying matrices
+	size_t const len = to - from;
 
-	for (size_t i = 0; i < matrix->m; i++) {
-		for (size_t j = 0; j < matrix->m; j++) {
-			double const val = bfm_matrix_get(src, i, j);
+	*part_from = from + len * (worker->id - 1) / (n_threads - 1);
+	*part_to = from + len * worker->id / (n_threads - 1);
+}
 
-			if (BFM_IS_NAN(val)) {
-				return -1;
-			}
+// pipelined blocked factorization, shared by the band LU & the symmetric band U^T D U factorization
+// panels are factorized by the first worker, which also does the part of the trailing update of the previous panel landing on the next one beforehand (a lookahead of one panel)
+// the rest of the trailing update is split between all workers, by groups of BAND_GROUP slices of BAND_NB columns
+// this way, all workers are busy with the update of a panel while the next one is being factorized, and each step only takes a single barrier
 
-			if (bfm_matrix_set(matrix, i, j, val) < 0) {
-				return -1;
-			}
-		}
+static void factorize_task(bfm_team_worker_t* worker) {
+	band_team_t* const team = worker->team->data;
+	size_t const m = team->matrix->m;
+	size_t const nb = BFM_MIN(BAND_NB, team->k);
+	size_t const n_threads = worker->team->n_threads;
+
+	if (worker->id == 0 && team->prepare(team, &team->panels[0], 0) < 0) {
+		worker->rv = -1;
+		team->failed = true;
 	}
 
-	return 0;
-}
+	for (size_t p = 0, i = 0; p < m; p += nb, i ^= 1) {
+		bfm_team_sync(worker->team);
 
-int bfm_matrix_destroy(bfm_matrix_t* matrix) {
-	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
-		return matrix_full_destroy(matrix);
-	}
+		if (team->failed) {
+			return;
+		}
 
-	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
-		return matrix_band_destroy(matrix);
-	}
+		band_panel_t const* const panel = &team->panels[i];
 
-	return -1;
-}
+		size_t const from = p + panel->b;
+		size_t const to = from + panel->n;
 
-double bfm_matrix_get(bfm_matrix_t* matrix, size_t i, size_t j) {
-	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
-		return matrix_full_get(matrix, i, j);
-	}
+		if (worker->id == 0 && from < m) {
+			team->update(team, panel, from, BFM_MIN(from + nb, to));
 
-	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
-		return matrix_band_get(matrix, i, j);
-	}
+			if (team->prepare(team, &team->panels[i ^ 1], from) < 0) {
+				worker->rv = -1;
+				team->failed = true;
+			}
+		}
 
-	return -1;
-}
+		// the slices after the lookahead are grouped by BAND_GROUP, and the groups split into as many contiguous runs as there are workers
+		// each group is updated in a single call, so that the BLAS calls of the update have the same shapes whatever the number of workers, and so do their results
 
-int bfm_matrix_set(bfm_matrix_t* matrix, size_t i, size_t j, double val) {
-	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
-		return matrix_full_set(matrix, i, j, val);
-	}
+		size_t const rest = from + nb;
+		size_t const group = BAND_GROUP * nb;
+		size_t const n_groups = to > rest ? (to - rest + group - 1) / group : 0;
 
-	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
-		return matrix_band_set(matrix, i, j, val);
-	}
+		size_t const first = n_groups * worker->id / n_threads;
+		size_t const last = n_groups * (worker->id + 1) / n_threads;
 
-	return -1;
+		for (size_t g = first; g < last; g++) {
+			team->update(team, panel, rest + g * group, BFM_MIN(rest + (g + 1) * group, to));
+		}
+	}
 }
 
-int bfm_matrix_add(bfm_matrix_t* matrix, size_t i, size_t j, double val) {
-	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
-		return matrix_full_add(matrix, i, j, val);
+static int band_factorize(bfm_matrix_t* matrix, size_t k, size_t work_len, int (*prepare)(band_team_t* team, band_panel_t* panel, size_t p), void (*update)(band_team_t* team, band_panel_t const* panel, size_t from, size_t to)) {
+	bfm_state_t* const state = matrix->state;
+
+	double* const work = state->alloc(4 * work_len * sizeof *work);
+
+	if (work == NULL) {
+		return -1;
 	}
 
-	else if (matrix->kind == BFM_MATRIX_KIND_BAND) {
-		return matrix_band_add(matrix, i, j, val);
+	band_team_t team = {
+		.matrix = matrix,
+		.k = k,
+		.prepare = prepare,
+		.update = update,
+		.failed = false,
+	};
+
+	for (size_t i = 0; i < 2; i++) {
+		team.panels[i].work = work + 2 * i * work_len;
+		team.panels[i].work_l = work + (2 * i + 1) * work_len;
 	}
 
-	return -1;
+	int const rv = bfm_team_run(state, factorize_task, &team, (double) matrix->m * k * k);
+
+	state->free(work);
+	return rv;
 }
 
-size_t bfm_matrix_bandwidth(bfm_matrix_t* matrix) {
-	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
-		return matrix_full_bandwidth(matrix);
-	}
+// blocked forward & backward substitutions, by blocks of BAND_NB rows
+// once a block is solved for, its contribution to the (at most k) rows past it is split between the workers, except for the rows of the next block, which the first worker takes care of before solving for that block straight away
+// each row receives the contributions of the pivots in the same order whichever worker goes through it, so results don't depend on the number of threads
 
-	else if (matrix->kind == BFM_MATRIX_KIND_BAND) {
-		return matrix_band_bandwidth(matrix);
-	}
+// y_i -= L(i,p) y_p for pivots p from q to e-1 & rows i from from to to-1, in order of p
+// with from = q & to = e, this solves for the block in place
+
+static void solve_lower_rows(band_team_t* team, size_t q, size_t e, size_t from, size_t to) {
+	size_t const k = team->k;
+	size_t const r = team->r;
+
+	for (size_t p = q; p < e; p++) {
+		double const* const col = team->diag + p * team->stride;
+		double const* const y_p = team->y + p * r;
+
+		size_t const start = BFM_MAX(p + 1, from);
+		size_t const len = BFM_MIN(p + k + 1, to);
+
+		if (start >= len) {
+			continue;
+		}
+
+		if (r == 1) {
+			axpy(len - start, -*y_p, col + start - p, team->y + start);
+			continue;
+		}
+
+		for (size_t i = start; i < len; i++) {
+			double const val = col[i - p];
+			double* const y_i = team->y + i * r;
+
+			for (size_t c = 0; c < r; c++) {
+				y_i[c] -= val * y_p[c];
+			}
+		}
+	}
+}
+
+static void solve_lower(bfm_team_worker_t* worker) {
+	band_team_t* const team = worker->team->data;
+	size_t const m = team->matrix->m;
+	size_t const k = team->k;
+
+	if (worker->id == 0) {
+		solve_lower_rows(team, 0, BFM_MIN(BAND_NB, m), 0, BFM_MIN(BAND_NB, m));
+	}
+
+	for (size_t q = 0; q < m; q += BAND_NB) {
+		size_t const e = BFM_MIN(q + BAND_NB, m);
+		size_t const end = BFM_MIN(e + k, m);
+		size_t const next = BFM_MIN(e + BAND_NB, end);
+
+		bfm_team_sync(worker->team);
+
+		if (worker->id == 0 && e < m) {
+			solve_lower_rows(team, q, e, e, next);
+			solve_lower_rows(team, e, BFM_MIN(e + BAND_NB, m), e, BFM_MIN(e + BAND_NB, m));
+		}
+
+		size_t from;
+		size_t to;
+
+		team_split(worker, next, end, &from, &to);
+		solve_lower_rows(team, q, e, from, to);
+	}
+}
+
+static void solve_upper(bfm_team_worker_t* worker) {
+	band_team_t* const team = worker->team->data;
+	size_t const m = team->matrix->m;
+	size_t const k = team->k;
+
+	if (m == 0) {
+		return;
+	}
+
+	size_t q = (m - 1) / BAND_NB * BAND_NB;
+
+	if (worker->id == 0 && team->upper_block(team, q, m) < 0) {
+		worker->rv = -1;
+	}
+
+	for (;;) {
+		size_t const e = BFM_MIN(q + BAND_NB, m);
+		size_t const start = q > k ? q - k : 0;
+		size_t const next = q > 0 ? BFM_MAX(q - BAND_NB, start) : 0;
+
+		bfm_team_sync(worker->team);
+
+		if (worker->id == 0 && q > 0) {
+			team->upper_rows(team, q, e, next, q);
+
+			if (team->upper_block(team, q - BAND_NB, q) < 0) {
+				worker->rv = -1;
+			}
+		}
+
+		size_t from;
+		size_t to;
+
+		team_split(worker, start, next, &from, &to);
+		team->upper_rows(team, q, e, from, to);
+
+		if (q == 0) {
+			break;
+		}
+
+		q -= BAND_NB;
+	}
+}
+
+static void solve_task(bfm_team_worker_t* worker) {
+	band_team_t* const team = worker->team->data;
+	size_t const m = team->matrix->m;
+	size_t const r = team->r;
+
+	solve_lower(worker);
+	bfm_team_sync(worker->team);
+
+	if (team->scale) {
+		size_t const from = m * worker->id / worker->team->n_threads;
+		size_t const to = m * (worker->id + 1) / worker->team->n_threads;
+
+		for (size_t i = from; i < to; i++) {
+			double const pivot = team->diag[i * team->stride];
+
+			if (BFM_IS_NAN(pivot) || !pivot) {
+				worker->rv = -1;
+				continue;
+			}
+
+			for (size_t c = 0; c < r; c++) {
+				team->y[i * r + c] /= pivot;
+			}
+		}
+
+		bfm_team_sync(worker->team);
+	}
+
+	solve_upper(worker);
+}
+
+static int band_solve(band_team_t* team, size_t r, double* y) {
+	team->r = r;
+	team->y = y;
+
+	return bfm_team_run(team->matrix->state, solve_task, team, 2. * team->matrix->m * team->k * r);
+}
+
+// unblocked band LU of columns from to to-1, only updating the columns before to
+// this is the whole factorization for narrow bands, and factorizes a panel of the blocked one otherwise
+
+static int band_lu_columns(bfm_matrix_t* matrix, size_t from, size_t to) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->band.k;
+
+	for (size_t pivot_i = from; pivot_i < to && pivot_i + 1 < m; pivot_i++) {
+		double* const pivot_col = matrix->band.data + band_idx(k, pivot_i, pivot_i);
+		double const pivot = pivot_col[0];
+
+		if (BFM_IS_NAN(pivot)) {
+			return -1;
+		}
+
+		if (fabs(pivot) < BFM_PIVOT_EPS) {
+			return -1;
+		}
+
+		size_t const len = BFM_MIN(pivot_i + k + 1, m);
+		size_t const below = len - pivot_i - 1;
+
+		// column of L below the pivot
+
+		for (size_t i = 1; i <= below; i++) {
+			pivot_col[i] /= pivot;
+		}
+
+		// update trailing columns within the band window
+		// column j only needs updating below row pivot_i, which is contiguous, just like the column of L
+
+		for (size_t j = pivot_i + 1; j < BFM_MIN(len, to); j++) {
+			double* const col = matrix->band.data + band_idx(k, pivot_i, j);
+			double const val = col[0];
+
+			if (!val) {
+				continue;
+			}
+
+			axpy(below, -val, pivot_col + 1, col + 1);
+		}
+	}
+
+	return 0;
+}
+
+// dense kernels for the blocked band factorizations, on column-major blocks
+// without BLAS, these go through the vector kernels
+
+// C -= AB (or AB^T if trans_b is set), with A mxkk, B kkxn (or nxkk) & C mxn
+
+static void gemm_sub(size_t m, size_t n, size_t kk, double const* a, size_t lda, double const* b, size_t ldb, bool trans_b, double* c, size_t ldc) {
+	if (!m || !n) {
+		return;
+	}
+
+#if defined(WITH_BLAS)
+	cblas_dgemm(CblasColMajor, CblasNoTrans, trans_b ? CblasTrans : CblasNoTrans, m, n, kk, -1, a, lda, b, ldb, 1, c, ldc);
+#else
+	bfm_kernel_dgemm_sub(m, n, kk, a, lda, b, trans_b ? ldb : 1, trans_b ? 1 : ldb, c, ldc);
+#endif
+}
+
+// B = L^-1 B, with L a unit lower triangular mxm block & B mxn
+
+static void trsm_lower_unit(size_t m, size_t n, double const* l, size_t ldl, double* b, size_t ldb) {
+	if (!m || !n) {
+		return;
+	}
+
+#if defined(WITH_BLAS)
+	cblas_dtrsm(CblasColMajor, CblasLeft, CblasLower, CblasNoTrans, CblasUnit, m, n, 1, l, ldl, b, ldb);
+#else
+	for (size_t j = 0; j < n; j++) {
+		double* const b_j = b + j * ldb;
+
+		for (size_t p = 0; p < m; p++) {
+			double const val = b_j[p];
+
+			if (!val) {
+				continue;
+			}
+
+			axpy(m - p - 1, -val, l + p * ldl + p + 1, b_j + p + 1);
+		}
+	}
+#endif
+}
+
+static bool all_zero(double const* x, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		if (x[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// blocked band LU, as in LAPACK's dgbtrf but without pivoting
+// panels of BAND_NB columns are factorized with the unblocked algorithm, after which the block row of U to their right is solved for and the trailing band window updated by dense matrix products
+// a dense block within the band is a column-major matrix of its own, with a leading dimension of 3k (each column of the band being shifted down by one row from the last)
+// the only part of the panel which doesn't fit in the band this way is the lower triangle of its bottom rows, which is copied out to a small work block
+
+static int band_lu_prepare(band_team_t* team, band_panel_t* panel, size_t p) {
+	bfm_matrix_t* const matrix = team->matrix;
+	size_t const m = matrix->m;
+	size_t const k = matrix->band.k;
+	size_t const nb = BFM_MIN(BAND_NB, k);
+	size_t const b = BFM_MIN(nb, m - p);
+
+	double const* const data = matrix->band.data;
+
+	if (band_lu_columns(matrix, p, p + b) < 0) {
+		return -1;
+	}
+
+	// the panel reaches down to row p + b + k - 1 at most, and the rows of its U block to column p + b + k - 1
+	// the band is usually quite a bit wider than the envelope of the matrix though, so trim the rows which are all zero (columns are trimmed slice by slice in band_lu_update)
+	// rows up to mid - 1 of the panel are entirely within the band, the ones after that only in its lower triangle
+
+	size_t end = p + b;
+
+	for (size_t j = p; j < p + b; j++) {
+		size_t col_end = BFM_MIN(j + k + 1, m);
+
+		while (col_end > end && !data[band_idx(k, col_end - 1, j)]) {
+			col_end--;
+		}
+
+		end = BFM_MAX(end, col_end);
+	}
+
+	size_t const mid = BFM_MIN(p + k, end);
+
+	for (size_t j = 0; end > mid && j < b; j++) {
+		for (size_t i = 0; i < end - mid; i++) {
+			panel->work[i + j * nb] = mid + i <= p + j + k ? data[band_idx(k, mid + i, p + j)] : 0;
+		}
+	}
+
+	panel->p = p;
+	panel->b = b;
+	panel->n = BFM_MIN(p + b + k, m) - (p + b);
+	panel->mid = mid;
+	panel->end = end;
+
+	return 0;
+}
+
+static void band_lu_update(band_team_t* team, band_panel_t const* panel, size_t from, size_t to) {
+	size_t const k = team->k;
+	size_t const p = panel->p;
+	size_t const b = panel->b;
+	size_t const ld = band_ld(k) - 1;
+
+	double* const data = team->matrix->band.data;
+
+	while (to > from && all_zero(data + band_idx(k, p, to - 1), b)) {
+		to--;
+	}
+
+	if (to == from) {
+		return;
+	}
+
+	trsm_lower_unit(b, to - from, data + band_idx(k, p, p), ld, data + band_idx(k, p, from), ld);
+
+	double const* const u = data + band_idx(k, p, from);
+
+	gemm_sub(panel->mid - (p + b), to - from, b, data + band_idx(k, p + b, p), ld, u, ld, false, data + band_idx(k, p + b, from), ld);
+	gemm_sub(panel->end - panel->mid, to - from, b, panel->work, BFM_MIN(BAND_NB, k), u, ld, false, data + band_idx(k, panel->mid, from), ld);
+}
+#endif
+
+static int matrix_band_lu(bfm_matrix_t* matrix) {
+#if defined(WITH_LAPACKE)
+	return matrix_band_lapacke_lu(matrix);
+#else
+	size_t const k = matrix->band.k;
+	size_t const nb = BFM_MIN(BAND_NB, k);
+
+	if (nb < BAND_NB_MIN) {
+		return band_lu_columns(matrix, 0, matrix->m);
+	}
+
+	return band_factorize(matrix, k, nb * nb, band_lu_prepare, band_lu_update);
+#endif
+}
+
+#if !defined(WITH_LAPACKE)
+// backward substitution with U, see solve_upper
+// U(i,p) is above the diagonal in column p, i.e. at a negative offset from it
+
+static int band_upper_block(band_team_t* team, size_t q, size_t e) {
+	size_t const k = team->k;
+	size_t const r = team->r;
+
+	for (size_t p = e; p-- > q;) {
+		size_t const start = BFM_MAX(p > k ? p - k : 0, q);
+		double const* const col = team->diag + p * team->stride - (p - start);
+		double const pivot = col[p - start];
+		double* const y_p = team->y + p * r;
+
+		if (BFM_IS_NAN(pivot) || !pivot) {
+			return -1;
+		}
+
+		for (size_t c = 0; c < r; c++) {
+			y_p[c] /= pivot;
+		}
+
+		if (r == 1) {
+			axpy(p - start, -*y_p, col, team->y + start);
+			continue;
+		}
+
+		for (size_t i = start; i < p; i++) {
+			double const val = col[i - start];
+			double* const y_i = team->y + i * r;
+
+			for (size_t c = 0; c < r; c++) {
+				y_i[c] -= val * y_p[c];
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void band_upper_rows(band_team_t* team, size_t q, size_t e, size_t from, size_t to) {
+	size_t const k = team->k;
+	size_t const r = team->r;
+
+	for (size_t p = e; p-- > q;) {
+		size_t const start = BFM_MAX(p > k ? p - k : 0, from);
+
+		if (start >= to) {
+			continue;
+		}
+
+		double const* const col = team->diag + p * team->stride - (p - start);
+		double const* const y_p = team->y + p * r;
+
+		if (r == 1) {
+			axpy(to - start, -*y_p, col, team->y + start);
+			continue;
+		}
+
+		for (size_t i = start; i < to; i++) {
+			double const val = col[i - start];
+			double* const y_i = team->y + i * r;
+
+			for (size_t c = 0; c < r; c++) {
+				y_i[c] -= val * y_p[c];
+			}
+		}
+	}
+}
+
+static int band_lu_solve(bfm_matrix_t* matrix, size_t r, double* y) {
+	size_t const k = matrix->band.k;
+
+	band_team_t team = {
+		.matrix = matrix,
+		.k = k,
+		.diag = matrix->band.data + band_idx(k, 0, 0),
+		.stride = band_ld(k),
+		.scale = false,
+		.upper_block = band_upper_block,
+		.upper_rows = band_upper_rows,
+	};
+
+	return band_solve(&team, r, y);
+}
+#endif
+
+static int matrix_band_lu_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
+#if defined(WITH_LAPACKE)
+	return band_lapacke_trs(matrix, 1, vec->data);
+#else
+	return band_lu_solve(matrix, 1, vec->data);
+#endif
+}
+
+static int matrix_band_lu_solve_multi(bfm_matrix_t* matrix, size_t r, double* y) {
+#if defined(WITH_LAPACKE)
+	return lapacke_solve_multi(matrix, r, y, band_lapacke_trs);
+#else
+	return band_lu_solve(matrix, r, y);
+#endif
+}
+
+// symmetric band matrix routines
+// only the upper half-band is stored: row i holds entries (i,i) to (i,i+k), contiguously
+// this is LAPACK's lower symmetric band layout, as column i of the lower half-band is row i of the upper one
+// entries below the diagonal are implied by symmetry, so writes to them are ignored
+
+static int matrix_sym_band_copy(bfm_matrix_t* matrix, bfm_matrix_t* src) {
+	if (matrix->sym_band.k != src->sym_band.k) {
+		return -1;
+	}
+
+	size_t const size = src->m * (src->sym_band.k + 1) * sizeof *src->sym_band.data;
+	memcpy(matrix->sym_band.data, src->sym_band.data, size);
+
+	return 0;
+}
+
+static int matrix_sym_band_destroy(bfm_matrix_t* matrix) {
+	bfm_state_t* const state = matrix->state;
+	state->free(matrix->sym_band.data);
+
+	return 0;
+}
+
+static double matrix_sym_band_get(bfm_matrix_t* matrix, size_t i, size_t j) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->sym_band.k;
+
+	if (i >= m || j >= m) {
+		return BFM_NAN;
+	}
+
+	if (j < i) {
+		size_t const tmp = i;
+		i = j;
+		j = tmp;
+	}
+
+	if (j - i > k) {
+		return 0;
+	}
+
+	return matrix->sym_band.data[i * (k + 1) + j - i];
+}
+
+static int matrix_sym_band_set(bfm_matrix_t* matrix, size_t i, size_t j, double value) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->sym_band.k;
+
+	if (i >= m || j >= m) {
+		return -1;
+	}
+
+	if (j < i) {
+		return 0;
+	}
+
+	if (j - i > k) {
+		return fabs(value) < BFM_PIVOT_EPS ? 0 : -1;
+	}
+
+	matrix->sym_band.data[i * (k + 1) + j - i] = value;
+	return 0;
+}
+
+static int matrix_sym_band_add(bfm_matrix_t* matrix, size_t i, size_t j, double value) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->sym_band.k;
+
+	if (i >= m || j >= m) {
+		return -1;
+	}
+
+	if (j < i) {
+		return 0;
+	}
+
+	if (j - i > k) {
+		return fabs(value) < BFM_PIVOT_EPS ? 0 : -1;
+	}
+
+	matrix->sym_band.data[i * (k + 1) + j - i] += value;
+	return 0;
+}
+
+static size_t matrix_sym_band_bandwidth(bfm_matrix_t* matrix) {
+	return matrix->sym_band.k;
+}
+
+// LDL^T (or rather U^T D U) factorization, without pivoting
+// D is stored on the diagonal and the strictly upper part of the unit upper triangular U above it
+// no square roots are needed, and only the half-band is ever touched, so this is about half the work of matrix_band_lu
+
+#if defined(WITH_LAPACKE)
+// LAPACK routines for symmetric band matrices
+// LAPACK only has a band Cholesky factorization, so this is LL^T rather than LDL^T
+
+static int matrix_sym_band_lapacke_llt(bfm_matrix_t* matrix) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->sym_band.k;
+
+	if (LAPACKE_dpbtrf(LAPACK_COL_MAJOR, 'L', m, k, matrix->sym_band.data, k + 1) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sym_band_lapacke_trs(bfm_matrix_t* matrix, size_t r, double* b) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->sym_band.k;
+
+	if (LAPACKE_dpbtrs(LAPACK_COL_MAJOR, 'L', m, k, r, matrix->sym_band.data, k + 1, b, m) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int matrix_sym_band_lapacke_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->sym_band.k;
+
+	if (LAPACKE_dpbsv(LAPACK_COL_MAJOR, 'L', m, k, 1, matrix->sym_band.data, k + 1, vec->data, m) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+#endif
+
+#if !defined(WITH_LAPACKE)
+// unblocked U^T D U factorization of rows from to to-1, only updating the rows before to
+// this is the whole factorization for narrow bands, and factorizes a panel of the blocked one otherwise
+// the trailing update of the blocked factorization needs the rows of the panel from column to onwards as they were before being scaled, so these are saved to w (with a leading dimension of ldw) if it isn't NULL
+
+static int sym_band_ldlt_rows(bfm_matrix_t* matrix, size_t from, size_t to, double* w, size_t ldw) {
+	size_t const m = matrix->m;
+	size_t const k = matrix->sym_band.k;
+	size_t const stride = k + 1;
+
+	for (size_t pivot_i = from; pivot_i < to; pivot_i++) {
+		double* const pivot_row = matrix->sym_band.data + pivot_i * stride;
+		double const pivot = pivot_row[0];
+
+		if (BFM_IS_NAN(pivot)) {
+			return -1;
+		}
+
+		if (fabs(pivot) < BFM_PIVOT_EPS) {
+			return -1;
+		}
+
+		size_t const len = BFM_MIN(pivot_i + k + 1, m);
+
+		// update trailing rows within the band window
+		// row i only needs updating from column i onwards, which is contiguous in both rows
+
+		for (size_t i = pivot_i + 1; i < BFM_MIN(len, to); i++) {
+			double* const row = matrix->sym_band.data + i * stride;
+			double const factor = pivot_row[i - pivot_i] / pivot;
+
+			axpy(len - i, -factor, pivot_row + i - pivot_i, row);
+		}
+
+		for (size_t j = to; w != NULL && j < len; j++) {
+			w[j - to + (pivot_i - from) * ldw] = pivot_row[j - pivot_i];
+		}
+
+		// scale pivot row to get the corresponding row of U
+
+		for (size_t j = pivot_i + 1; j < len; j++) {
+			pivot_row[j - pivot_i] /= pivot;
+		}
+	}
+
+	return 0;
+}
+
+// blocked U^T D U factorization, pipelined in the same way as matrix_band_lu (see factorize_task)
+// in terms of the lower half-band (i.e. with rows & columns swapped), the trailing update of a panel is A22 -= W D^-1 W^T, W being the unscaled rows of the panel right of it (saved to the work block of the panel) & W D^-1 the corresponding scaled ones (saved to its work_l block)
+// only the lower triangle of A22 is stored, so each slice of columns of it is updated by a dense matrix product below its diagonal block, and entry by entry within it
+// a dense block within the lower half-band is a column-major matrix with a leading dimension of k
+
+static int sym_band_ldlt_prepare(band_team_t* team, band_panel_t* panel, size_t p) {
+	bfm_matrix_t* const matrix = team->matrix;
+	size_t const m = matrix->m;
+	size_t const k = matrix->sym_band.k;
+	size_t const b = BFM_MIN(BFM_MIN(BAND_NB, k), m - p);
+
+	double const* const data = matrix->sym_band.data;
+	double* const w = panel->work;
+
+	memset(w, 0, k * b * sizeof *w);
+
+	if (sym_band_ldlt_rows(matrix, p, p + b, w, k) < 0) {
+		return -1;
+	}
+
+	// trim the trailing update to the rows of the panel within the envelope of the matrix, as in band_lu_prepare
+
+	size_t const rows = BFM_MIN(p + b + k, m) - (p + b);
+	size_t n = 0;
+
+	for (size_t l = 0; l < b; l++) {
+		size_t row_end = rows;
+
+		while (row_end > n && !w[row_end - 1 + l * k]) {
+			row_end--;
+		}
+
+		n = BFM_MAX(n, row_end);
+	}
+
+	for (size_t l = 0; l < b; l++) {
+		double const pivot = data[(p + l) * (k + 1)];
+
+		for (size_t i = 0; i < n; i++) {
+			panel->work_l[i + l * k] = w[i + l * k] / pivot;
+		}
+	}
+
+	panel->p = p;
+	panel->b = b;
+	panel->n = n;
+	panel->end = p + b + n;
+
+	return 0;
+}
+
+static void sym_band_ldlt_update(band_team_t* team, band_panel_t const* panel, size_t from, size_t to) {
+	size_t const k = team->k;
+	size_t const nb = BFM_MIN(BAND_NB, k);
+	size_t const base = panel->p + panel->b;
+
+	double* const data = team->matrix->sym_band.data;
+	double const* const w = panel->work;
+	double const* const w_l = panel->work_l;
+
+	for (size_t c = from; c < to; c += nb) {
+		size_t const c_end = BFM_MIN(c + nb, to);
+
+		// diagonal block, row by row of U
+
+		for (size_t i = c; i < c_end; i++) {
+			double* const row = data + i * (k + 1);
+
+			for (size_t l = 0; l < panel->b; l++) {
+				double const factor = w_l[i - base + l * k];
+
+				if (!factor) {
+					continue;
+				}
+
+				double const* const w_row = w + l * k;
+
+				axpy(c_end - i, -factor, w_row + i - base, row);
+			}
+		}
+
+		gemm_sub(panel->end - c_end, c_end - c, panel->b, w + c_end - base, k, w_l + c - base, k, true, data + c * (k + 1) + c_end - c, k);
+	}
+}
+#endif
+
+static int matrix_sym_band_ldlt(bfm_matrix_t* matrix) {
+#if defined(WITH_LAPACKE)
+	return matrix_sym_band_lapacke_llt(matrix);
+#else
+	size_t const k = matrix->sym_band.k;
+	size_t const nb = BFM_MIN(BAND_NB, k);
+
+	if (nb < BAND_NB_MIN) {
+		return sym_band_ldlt_rows(matrix, 0, matrix->m, NULL, 0);
+	}
+
+	return band_factorize(matrix, k, k * nb, sym_band_ldlt_prepare, sym_band_ldlt_update);
+#endif
+}
+
+#if !defined(WITH_LAPACKE)
+// backward substitution with U, see solve_upper
+// row p of U is contiguous, so each row takes the contributions of the rows of the solution already known as a dot product
+// y_p -= U(p,i) y_i for rows p from to-1 down to from & i from q to e-1, which solves for the block in place if from = q & to = e
+
+static void sym_band_upper_rows(band_team_t* team, size_t q, size_t e, size_t from, size_t to) {
+	size_t const k = team->k;
+	size_t const r = team->r;
+
+	for (size_t p = to; p-- > from;) {
+		double const* const row = team->diag + p * team->stride;
+		double* const y_p = team->y + p * r;
+
+		size_t const start = BFM_MAX(p + 1, q);
+		size_t const len = BFM_MIN(p + k + 1, e);
+
+		if (start >= len) {
+			continue;
+		}
+
+		if (r == 1) {
+			*y_p -= dot(len - start, row + start - p, team->y + start);
+			continue;
+		}
+
+		for (size_t i = start; i < len; i++) {
+			double const val = row[i - p];
+			double const* const y_i = team->y + i * r;
+
+			for (size_t c = 0; c < r; c++) {
+				y_p[c] -= val * y_i[c];
+			}
+		}
+	}
+}
+
+static int sym_band_upper_block(band_team_t* team, size_t q, size_t e) {
+	sym_band_upper_rows(team, q, e, q, e);
+	return 0;
+}
+
+// forward substitution U^T z = y goes column by column of U^T, i.e. row by row of U, which is just what solve_lower expects of a column of L
+
+static int sym_band_ldlt_solve(bfm_matrix_t* matrix, size_t r, double* y) {
+	size_t const k = matrix->sym_band.k;
+
+	band_team_t team = {
+		.matrix = matrix,
+		.k = k,
+		.diag = matrix->sym_band.data,
+		.stride = k + 1,
+		.scale = true,
+		.upper_block = sym_band_upper_block,
+		.upper_rows = sym_band_upper_rows,
+	};
+
+	return band_solve(&team, r, y);
+}
+#endif
+
+static int matrix_sym_band_ldlt_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
+#if defined(WITH_LAPACKE)
+	return sym_band_lapacke_trs(matrix, 1, vec->data);
+#else
+	return sym_band_ldlt_solve(matrix, 1, vec->data);
+#endif
+}
+
+static int matrix_sym_band_ldlt_solve_multi(bfm_matrix_t* matrix, size_t r, double* y) {
+#if defined(WITH_LAPACKE)
+	return lapacke_solve_multi(matrix, r, y, sym_band_lapacke_trs);
+#else
+	return sym_band_ldlt_solve(matrix, r, y);
+#endif
+}
+
+// compressed sparse row matrix routines
+
+static int matrix_csr_copy(bfm_matrix_t* matrix, bfm_matrix_t* src) {
+	size_t const m = src->m;
+
+	// only matrices sharing the exact same sparsity pattern can be copied directly
+
+	if (matrix->csr.nnz != src->csr.nnz) {
+		return -1;
+	}
+
+	if (matrix->csr.offsets == src->csr.offsets && matrix->csr.cols == src->csr.cols) {
+		goto copy;
+	}
+
+	if (memcmp(matrix->csr.offsets, src->csr.offsets, (m + 1) * sizeof *src->csr.offsets)) {
+		return -1;
+	}
+
+	if (memcmp(matrix->csr.cols, src->csr.cols, src->csr.nnz * sizeof *src->csr.cols)) {
+		return -1;
+	}
+
+copy:
+
+	memcpy(matrix->csr.data, src->csr.data, src->csr.nnz * sizeof *src->csr.data);
+
+	return 0;
+}
+
+static int matrix_csr_destroy(bfm_matrix_t* matrix) {
+	bfm_state_t* const state = matrix->state;
+
+	if (!matrix->csr.shared) {
+		state->free(matrix->csr.offsets);
+		state->free(matrix->csr.cols);
+	}
+
+	state->free(matrix->csr.data);
+
+	return 0;
+}
+
+// find the index of entry (i,j) in the data array, -1 if it's not in the sparsity pattern
+
+static ssize_t matrix_csr_find(bfm_matrix_t* matrix, size_t i, size_t j) {
+	size_t lo = matrix->csr.offsets[i];
+	size_t hi = matrix->csr.offsets[i + 1];
+
+	while (lo < hi) {
+		size_t const mid = lo + (hi - lo) / 2;
+		size_t const col = matrix->csr.cols[mid];
+
+		if (col == j) {
+			return mid;
+		}
+
+		if (col < j) {
+			lo = mid + 1;
+		}
+
+		else {
+			hi = mid;
+		}
+	}
+
+	return -1;
+}
+
+static double matrix_csr_get(bfm_matrix_t* matrix, size_t i, size_t j) {
+	if (i >= matrix->m || j >= matrix->m) {
+		return BFM_NAN;
+	}
+
+	ssize_t const idx = matrix_csr_find(matrix, i, j);
+
+	if (idx < 0) {
+		return 0;
+	}
+
+	return matrix->csr.data[idx];
+}
+
+static int matrix_csr_set(bfm_matrix_t* matrix, size_t i, size_t j, double value) {
+	if (i >= matrix->m || j >= matrix->m) {
+		return -1;
+	}
+
+	ssize_t const idx = matrix_csr_find(matrix, i, j);
+
+	if (idx < 0) {
+		return fabs(value) < BFM_PIVOT_EPS ? 0 : -1;
+	}
+
+	matrix->csr.data[idx] = value;
+	return 0;
+}
+
+static int matrix_csr_add(bfm_matrix_t* matrix, size_t i, size_t j, double value) {
+	if (i >= matrix->m || j >= matrix->m) {
+		return -1;
+	}
+
+	ssize_t const idx = matrix_csr_find(matrix, i, j);
+
+	if (idx < 0) {
+		return fabs(value) < BFM_PIVOT_EPS ? 0 : -1;
+	}
+
+	matrix->csr.data[idx] += value;
+	return 0;
+}
+
+static size_t matrix_csr_bandwidth(bfm_matrix_t* matrix) {
+	size_t k = 0;
+
+	for (ssize_t i = 0; i < (ssize_t) matrix->m; i++) {
+		for (size_t idx = matrix->csr.offsets[i]; idx < matrix->csr.offsets[i + 1]; idx++) {
+			if (!matrix->csr.data[idx]) {
+				continue;
+			}
+
+			ssize_t const j = matrix->csr.cols[idx];
+			k = BFM_MAX((ssize_t) k, BFM_ABS(i - j));
+		}
+	}
+
+	return k;
+}
+
+// zero out a matrix of any kind
+
+static void matrix_zero(bfm_matrix_t* matrix) {
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		memset(matrix->full.data, 0, matrix->m * matrix->m * sizeof *matrix->full.data);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		memset(matrix->band.data, 0, matrix->m * band_ld(matrix->band.k) * sizeof *matrix->band.data);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		memset(matrix->sym_band.data, 0, matrix->m * (matrix->sym_band.k + 1) * sizeof *matrix->sym_band.data);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		memset(matrix->csr.data, 0, matrix->csr.nnz * sizeof *matrix->csr.data);
+	}
+}
+
+// copy a sparse matrix into a matrix of any kind by only going through its non-zero entries
+
+static int matrix_csr_scatter(bfm_matrix_t* matrix, bfm_matrix_t* src) {
+	matrix_zero(matrix);
+
+	for (size_t i = 0; i < src->m; i++) {
+		for (size_t idx = src->csr.offsets[i]; idx < src->csr.offsets[i + 1]; idx++) {
+			if (bfm_matrix_set(matrix, i, src->csr.cols[idx], src->csr.data[idx]) < 0) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// generic matrix routines
+
+int bfm_matrix_copy(bfm_matrix_t* matrix, bfm_matrix_t* src) {
+	if (matrix->m != src->m) {
+		return -1;
+	}
+
+	// bespoke copying functions
+	// these are here to make copying faster than the generic method
+
+	if (matrix->kind == BFM_MATRIX_KIND_FULL && src->kind == BFM_MATRIX_KIND_FULL) {
+		return matrix_full_copy(matrix, src);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_BAND && src->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_copy(matrix, src);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND && src->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_copy(matrix, src);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_CSR && src->kind == BFM_MATRIX_KIND_CSR && matrix_csr_copy(matrix, src) == 0) {
+		return 0;
+	}
+
+	// sparse matrices only need their non-zero entries to be copied over
+
+	if (src->kind == BFM_MATRIX_KIND_CSR) {
+		return matrix_csr_scatter(matrix, src);
+	}
+
+	// generic method for copying matrices
+
+	for (size_t i = 0; i < matrix->m; i++) {
+		for (size_t j = 0; j < matrix->m; j++) {
+			double const val = bfm_matrix_get(src, i, j);
+
+			if (BFM_IS_NAN(val)) {
+				return -1;
+			}
+
+			if (bfm_matrix_set(matrix, i, j, val) < 0) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int bfm_matrix_destroy(bfm_matrix_t* matrix) {
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		return matrix_full_destroy(matrix);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_destroy(matrix);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_destroy(matrix);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		return matrix_csr_destroy(matrix);
+	}
+
+	return -1;
+}
+
+double bfm_matrix_get(bfm_matrix_t* matrix, size_t i, size_t j) {
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		return matrix_full_get(matrix, i, j);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_get(matrix, i, j);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_get(matrix, i, j);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		return matrix_csr_get(matrix, i, j);
+	}
+
+	return -1;
+}
+
+int bfm_matrix_set(bfm_matrix_t* matrix, size_t i, size_t j, double val) {
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		return matrix_full_set(matrix, i, j, val);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_set(matrix, i, j, val);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_set(matrix, i, j, val);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		return matrix_csr_set(matrix, i, j, val);
+	}
+
+	return -1;
+}
+
+int bfm_matrix_add(bfm_matrix_t* matrix, size_t i, size_t j, double val) {
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		return matrix_full_add(matrix, i, j, val);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_add(matrix, i, j, val);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_add(matrix, i, j, val);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		return matrix_csr_add(matrix, i, j, val);
+	}
+
+	return -1;
+}
+
+// block offsets per matrix kind
+// these index straight into each kind's data array, following the same layouts as the get/set/add functions
+
+static int matrix_full_block_offsets(bfm_matrix_t* matrix, size_t n, size_t const* dofs, size_t* offsets) {
+	size_t const m = matrix->m;
+
+	for (size_t a = 0; a < n; a++) {
+		for (size_t b = 0; b < n; b++) {
+			size_t const i = dofs[a];
+			size_t const j = dofs[b];
+
+			offsets[a * n + b] = matrix->major == BFM_MATRIX_MAJOR_ROW ? i * m + j : i + j * m;
+		}
+	}
+
+	return 0;
+}
+
+static int matrix_band_block_offsets(bfm_matrix_t* matrix, size_t n, size_t const* dofs, size_t* offsets) {
+	size_t const k = matrix->band.k;
+
+	for (size_t a = 0; a < n; a++) {
+		for (size_t b = 0; b < n; b++) {
+			size_t const i = dofs[a];
+			size_t const j = dofs[b];
+
+			if (BFM_ABS((ssize_t) i - (ssize_t) j) > (ssize_t) k) {
+				return -1;
+			}
+
+			offsets[a * n + b] = band_idx(k, i, j);
+		}
+	}
+
+	return 0;
+}
+
+static int matrix_sym_band_block_offsets(bfm_matrix_t* matrix, size_t n, size_t const* dofs, size_t* offsets) {
+	size_t const k = matrix->sym_band.k;
+
+	for (size_t a = 0; a < n; a++) {
+		for (size_t b = 0; b < n; b++) {
+			size_t const i = dofs[a];
+			size_t const j = dofs[b];
+
+			if (j < i) {
+				offsets[a * n + b] = BFM_MATRIX_NO_OFFSET;
+				continue;
+			}
+
+			if (j - i > k) {
+				return -1;
+			}
+
+			offsets[a * n + b] = i * (k + 1) + j - i;
+		}
+	}
+
+	return 0;
+}
+
+static int matrix_csr_block_offsets(bfm_matrix_t* matrix, size_t n, size_t const* dofs, size_t* offsets) {
+	bfm_matrix_csr_t* const csr = &matrix->csr;
+
+	for (size_t a = 0; a < n; a++) {
+		size_t const end = csr->offsets[dofs[a] + 1];
+		ssize_t idx = -1;
+
+		for (size_t b = 0; b < n; b++) {
+			// consecutive DOFs (e.g. those of a same node) are usually next to each other in the row, so check the next entry before searching
+
+			if (idx >= 0 && (size_t) idx + 1 < end && csr->cols[idx + 1] == dofs[b]) {
+				idx++;
+			}
+
+			else {
+				idx = matrix_csr_find(matrix, dofs[a], dofs[b]);
+			}
+
+			if (idx < 0) {
+				return -1;
+			}
+
+			offsets[a * n + b] = idx;
+		}
+	}
+
+	return 0;
+}
+
+int bfm_matrix_block_offsets(bfm_matrix_t* matrix, size_t n, size_t const* dofs, size_t* offsets) {
+	for (size_t a = 0; a < n; a++) {
+		if (dofs[a] >= matrix->m) {
+			return -1;
+		}
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		return matrix_full_block_offsets(matrix, n, dofs, offsets);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_block_offsets(matrix, n, dofs, offsets);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_block_offsets(matrix, n, dofs, offsets);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		return matrix_csr_block_offsets(matrix, n, dofs, offsets);
+	}
+
+	return -1;
+}
+
+int bfm_matrix_add_block(bfm_matrix_t* matrix, size_t n, size_t const* offsets, double const* block) {
+	double* data = NULL;
+
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		data = matrix->full.data;
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		data = matrix->band.data;
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		data = matrix->sym_band.data;
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		data = matrix->csr.data;
+	}
+
+	if (data == NULL) {
+		return -1;
+	}
+
+	for (size_t a = 0; a < n * n; a++) {
+		if (offsets[a] != BFM_MATRIX_NO_OFFSET) {
+			data[offsets[a]] += block[a];
+		}
+	}
+
+	return 0;
+}
+
+size_t bfm_matrix_bandwidth(bfm_matrix_t* matrix) {
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		return matrix_full_bandwidth(matrix);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_bandwidth(matrix);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_bandwidth(matrix);
+	}
+
+	else if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		return matrix_csr_bandwidth(matrix);
+	}
 
 	return -1;
 }
@@ -509,6 +1849,10 @@ int bfm_matrix_lu(bfm_matrix_t* matrix) {
 		return matrix_band_lu(matrix);
 	}
 
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_ldlt(matrix);
+	}
+
 	return -1;
 }
 
@@ -525,10 +1869,50 @@ int bfm_matrix_lu_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
 		return matrix_band_lu_solve(matrix, vec);
 	}
 
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_ldlt_solve(matrix, vec);
+	}
+
+	return -1;
+}
+
+int bfm_matrix_lu_solve_multi(bfm_matrix_t* matrix, size_t r, bfm_vec_t* vec) {
+	if (matrix->m * r != vec->n) {
+		return -1;
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_FULL) {
+		return matrix_full_lu_solve_multi(matrix, r, vec->data);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_lu_solve_multi(matrix, r, vec->data);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_ldlt_solve_multi(matrix, r, vec->data);
+	}
+
 	return -1;
 }
 
 int bfm_matrix_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
+#if defined(WITH_LAPACKE)
+	// LAPACK can factorize & solve band matrices in one go
+
+	if (matrix->m != vec->n) {
+		return -1;
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_BAND) {
+		return matrix_band_lapacke_solve(matrix, vec);
+	}
+
+	if (matrix->kind == BFM_MATRIX_KIND_SYM_BAND) {
+		return matrix_sym_band_lapacke_solve(matrix, vec);
+	}
+#endif
+
 	if (bfm_matrix_lu(matrix) < 0) {
 		return -1;
 	}
@@ -540,6 +1924,367 @@ int bfm_matrix_solve(bfm_matrix_t* matrix, bfm_vec_t* vec) {
 	return 0;
 }
 
+// preconditioned conjugate gradient solver
+// everything here works directly on the CSR matrix, so no renumbering or band conversion is needed
+
+typedef struct {
+	bfm_state_t* state;
+	bfm_precond_kind_t kind;
+
+	size_t* diag; // index of each row's diagonal entry in the CSR data array
+	double* data; // inverse diagonal for Jacobi, incomplete factor for IC0
+} precond_t;
+
+static void precond_destroy(precond_t* precond) {
+	bfm_state_t* const state = precond->state;
+
+	state->free(precond->diag);
+	state->free(precond->data);
+}
+
+// IC0 in its square-root-free form: on a symmetric pattern, ILU(0) is exactly an incomplete U^T D U factorization
+// L (unit, strictly lower part) and D U (upper part, diagonal included) are stored in place of A's entries
+// shift scales the diagonal up before factorizing, which is how breakdowns on non-M-matrices are avoided
+
+static int precond_ic0_factor(precond_t* precond, bfm_matrix_t* matrix, size_t* pos, double shift) {
+	bfm_matrix_csr_t* const csr = &matrix->csr;
+	double* const data = precond->data;
+
+	memcpy(data, csr->data, csr->nnz * sizeof *data);
+
+	for (size_t i = 0; i < matrix->m; i++) {
+		data[precond->diag[i]] *= 1 + shift;
+	}
+
+	for (size_t i = 0; i < matrix->m; i++) {
+		size_t const start = csr->offsets[i];
+		size_t const end = csr->offsets[i + 1];
+
+		// pos maps a column to its index in row i, for the fill-in-free updates
+
+		for (size_t idx = start; idx < end; idx++) {
+			pos[csr->cols[idx]] = idx;
+		}
+
+		for (size_t idx = start; idx < precond->diag[i]; idx++) {
+			size_t const k = csr->cols[idx];
+			data[idx] /= data[precond->diag[k]];
+
+			for (size_t kj = precond->diag[k] + 1; kj < csr->offsets[k + 1]; kj++) {
+				size_t const j = csr->cols[kj];
+
+				if (pos[j] != (size_t) -1) {
+					data[pos[j]] -= data[idx] * data[kj];
+				}
+			}
+		}
+
+		double const pivot = data[precond->diag[i]];
+
+		for (size_t idx = start; idx < end; idx++) {
+			pos[csr->cols[idx]] = -1;
+		}
+
+		if (BFM_IS_NAN(pivot) || pivot < BFM_PIVOT_EPS) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int precond_create(precond_t* precond, bfm_state_t* state, bfm_matrix_t* matrix, bfm_precond_kind_t kind) {
+	bfm_matrix_csr_t* const csr = &matrix->csr;
+	size_t const m = matrix->m;
+
+	memset(precond, 0, sizeof *precond);
+
+	precond->state = state;
+	precond->kind = kind;
+
+	if (kind == BFM_PRECOND_KIND_NONE) {
+		return 0;
+	}
+
+	// find diagonal entries, which all need to be in the sparsity pattern
+
+	precond->diag = state->alloc(m * sizeof *precond->diag);
+
+	if (precond->diag == NULL) {
+		return -1;
+	}
+
+	for (size_t i = 0; i < m; i++) {
+		ssize_t const idx = matrix_csr_find(matrix, i, i);
+
+		if (idx < 0 || !csr->data[idx]) {
+			state->free(precond->diag);
+			return -1;
+		}
+
+		precond->diag[i] = idx;
+	}
+
+	if (kind == BFM_PRECOND_KIND_SGS) {
+		return 0;
+	}
+
+	if (kind == BFM_PRECOND_KIND_JACOBI) {
+		precond->data = state->alloc(m * sizeof *precond->data);
+
+		if (precond->data == NULL) {
+			state->free(precond->diag);
+			return -1;
+		}
+
+		for (size_t i = 0; i < m; i++) {
+			precond->data[i] = 1 / csr->data[precond->diag[i]];
+		}
+
+		return 0;
+	}
+
+	if (kind == BFM_PRECOND_KIND_IC0) {
+		precond->data = state->alloc(csr->nnz * sizeof *precond->data);
+		size_t* const pos = state->alloc(m * sizeof *pos);
+
+		if (precond->data == NULL || pos == NULL) {
+			state->free(pos);
+			precond_destroy(precond);
+			return -1;
+		}
+
+		memset(pos, 0xff, m * sizeof *pos); // i.e. (size_t) -1 everywhere
+
+		// retry with an increasing diagonal shift until the factorization doesn't break down
+
+		int rv = -1;
+
+		for (double shift = 0; shift < 1; shift = shift ? shift * 2 : 1e-3) {
+			if ((rv = precond_ic0_factor(precond, matrix, pos, shift)) == 0) {
+				break;
+			}
+
+			memset(pos, 0xff, m * sizeof *pos);
+		}
+
+		state->free(pos);
+
+		if (rv < 0) {
+			precond_destroy(precond);
+		}
+
+		return rv;
+	}
+
+	state->free(precond->diag);
+	return -1;
+}
+
+// z = M^-1 r
+
+static void precond_apply(precond_t* precond, bfm_matrix_t* matrix, double const* r, double* z) {
+	bfm_matrix_csr_t* const csr = &matrix->csr;
+	size_t const m = matrix->m;
+
+	if (precond->kind == BFM_PRECOND_KIND_NONE) {
+		memcpy(z, r, m * sizeof *z);
+	}
+
+	else if (precond->kind == BFM_PRECOND_KIND_JACOBI) {
+		for (size_t i = 0; i < m; i++) {
+			z[i] = precond->data[i] * r[i];
+		}
+	}
+
+	// M = (D + L) D^-1 (D + U)
+
+	else if (precond->kind == BFM_PRECOND_KIND_SGS) {
+		for (size_t i = 0; i < m; i++) {
+			double sum = r[i];
+
+			for (size_t idx = csr->offsets[i]; idx < precond->diag[i]; idx++) {
+				sum -= csr->data[idx] * z[csr->cols[idx]];
+			}
+
+			z[i] = sum / csr->data[precond->diag[i]];
+		}
+
+		for (size_t i = 0; i < m; i++) {
+			z[i] *= csr->data[precond->diag[i]];
+		}
+
+		for (ssize_t i = m - 1; i >= 0; i--) {
+			double sum = z[i];
+
+			for (size_t idx = precond->diag[i] + 1; idx < csr->offsets[i + 1]; idx++) {
+				sum -= csr->data[idx] * z[csr->cols[idx]];
+			}
+
+			z[i] = sum / csr->data[precond->diag[i]];
+		}
+	}
+
+	// M = L (D U), with L unit lower triangular
+
+	else if (precond->kind == BFM_PRECOND_KIND_IC0) {
+		double const* const data = precond->data;
+
+		for (size_t i = 0; i < m; i++) {
+			double sum = r[i];
+
+			for (size_t idx = csr->offsets[i]; idx < precond->diag[i]; idx++) {
+				sum -= data[idx] * z[csr->cols[idx]];
+			}
+
+			z[i] = sum;
+		}
+
+		for (ssize_t i = m - 1; i >= 0; i--) {
+			double sum = z[i];
+
+			for (size_t idx = precond->diag[i] + 1; idx < csr->offsets[i + 1]; idx++) {
+				sum -= data[idx] * z[csr->cols[idx]];
+			}
+
+			z[i] = sum / data[precond->diag[i]];
+		}
+	}
+}
+
+// y = A x
+
+static void matrix_csr_mul(bfm_matrix_t* matrix, double const* x, double* y) {
+	bfm_matrix_csr_t* const csr = &matrix->csr;
+
+	for (size_t i = 0; i < matrix->m; i++) {
+		double sum = 0;
+
+		for (size_t idx = csr->offsets[i]; idx < csr->offsets[i + 1]; idx++) {
+			sum += csr->data[idx] * x[csr->cols[idx]];
+		}
+
+		y[i] = sum;
+	}
+}
+
+int bfm_pcg_default(bfm_pcg_t* pcg) {
+	memset(pcg, 0, sizeof *pcg);
+
+	pcg->precond = BFM_PRECOND_KIND_IC0;
+	pcg->tol = 1e-10;
+	pcg->max_iter = 0;
+
+	return 0;
+}
+
+int bfm_matrix_solve_pcg(bfm_matrix_t* matrix, bfm_vec_t* vec, bfm_pcg_t* pcg) {
+	int rv = -1;
+
+	bfm_state_t* const state = matrix->state;
+	size_t const m = matrix->m;
+
+	if (matrix->kind != BFM_MATRIX_KIND_CSR) {
+		goto err_kind;
+	}
+
+	if (vec->n != m) {
+		goto err_kind;
+	}
+
+	pcg->n_iter = 0;
+	pcg->residual = 0;
+
+	// trivial case, and avoids dividing by zero later
+
+	double const b_norm = sqrt(dot(m, vec->data, vec->data));
+
+	if (!b_norm) {
+		rv = 0;
+		goto err_kind;
+	}
+
+	precond_t precond;
+
+	if (precond_create(&precond, state, matrix, pcg->precond) < 0) {
+		goto err_precond;
+	}
+
+	// workspace for the solution x, residual r, preconditioned residual z, search direction p and q = Ap
+
+	double* const work = state->alloc(5 * m * sizeof *work);
+
+	if (work == NULL) {
+		goto err_work;
+	}
+
+	double* const x = work + 0 * m;
+	double* const r = work + 1 * m;
+	double* const z = work + 2 * m;
+	double* const p = work + 3 * m;
+	double* const q = work + 4 * m;
+
+	memset(x, 0, m * sizeof *x);
+	memcpy(r, vec->data, m * sizeof *r);
+
+	precond_apply(&precond, matrix, r, z);
+	memcpy(p, z, m * sizeof *p);
+
+	double rz = dot(m, r, z);
+	size_t const max_iter = pcg->max_iter ? pcg->max_iter : m;
+
+	while (pcg->n_iter < max_iter) {
+		matrix_csr_mul(matrix, p, q);
+
+		double const pq = dot(m, p, q);
+
+		if (BFM_IS_NAN(pq) || !pq) {
+			break;
+		}
+
+		double const alpha = rz / pq;
+
+		for (size_t i = 0; i < m; i++) {
+			x[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+		}
+
+		pcg->n_iter++;
+		pcg->residual = sqrt(dot(m, r, r)) / b_norm;
+
+		if (pcg->residual <= pcg->tol) {
+			break;
+		}
+
+		precond_apply(&precond, matrix, r, z);
+
+		double const rz_next = dot(m, r, z);
+		double const beta = rz_next / rz;
+
+		rz = rz_next;
+
+		for (size_t i = 0; i < m; i++) {
+			p[i] = z[i] + beta * p[i];
+		}
+	}
+
+	// success (if converged)
+
+	memcpy(vec->data, x, m * sizeof *x);
+	rv = pcg->residual <= pcg->tol ? 0 : -1;
+
+	state->free(work);
+
+err_work:
+
+	precond_destroy(&precond);
+
+err_precond:
+err_kind:
+
+	return rv;
+}
+
 // creation functions
 
 static int matrix_create(bfm_matrix_t* matrix, bfm_state_t* state, bfm_matrix_kind_t kind, bfm_matrix_major_t major, size_t m) {
@@ -567,11 +2312,12 @@ int bfm_matrix_full_create(bfm_matrix_t* matrix, bfm_state_t* state, bfm_matrix_
 	return 0;
 }
 
-int bfm_matrix_band_create(bfm_matrix_t* matrix, bfm_state_t* state, bfm_matrix_major_t major, size_t m, size_t k) {
-	matrix_create(matrix, state, BFM_MATRIX_KIND_BAND, major, m);
+int bfm_matrix_band_create(bfm_matrix_t* matrix, bfm_state_t* state, size_t m, size_t k) {
+	matrix_create(matrix, state, BFM_MATRIX_KIND_BAND, BFM_MATRIX_MAJOR_COLUMN, m);
 	matrix->band.k = k;
+	matrix->band.pivots = NULL;
 
-	size_t const size = m * (k * 2 + 1) * sizeof *matrix->band.data;
+	size_t const size = m * band_ld(k) * sizeof *matrix->band.data;
 	matrix->band.data = state->alloc(size);
 
 	if (matrix->band.data == NULL) {
@@ -582,3 +2328,91 @@ int bfm_matrix_band_create(bfm_matrix_t* matrix, bfm_state_t* state, bfm_matrix_
 
 	return 0;
 }
+
+int bfm_matrix_sym_band_create(bfm_matrix_t* matrix, bfm_state_t* state, size_t m, size_t k) {
+	matrix_create(matrix, state, BFM_MATRIX_KIND_SYM_BAND, BFM_MATRIX_MAJOR_ROW, m);
+	matrix->sym_band.k = k;
+	matrix->sym_band.pivots = NULL;
+
+	size_t const size = m * (k + 1) * sizeof *matrix->sym_band.data;
+	matrix->sym_band.data = state->alloc(size);
+
+	if (matrix->sym_band.data == NULL) {
+		return -1;
+	}
+
+	memset(matrix->sym_band.data, 0, size);
+
+	return 0;
+}
+
+int bfm_matrix_csr_create(bfm_matrix_t* matrix, bfm_state_t* state, size_t m, size_t const* offsets, size_t const* cols) {
+	matrix_create(matrix, state, BFM_MATRIX_KIND_CSR, BFM_MATRIX_MAJOR_ROW, m);
+
+	size_t const nnz = offsets[m];
+	matrix->csr.nnz = nnz;
+	matrix->csr.shared = false;
+
+	size_t const offsets_size = (m + 1) * sizeof *matrix->csr.offsets;
+	matrix->csr.offsets = state->alloc(offsets_size);
+
+	if (matrix->csr.offsets == NULL) {
+		goto err_offsets;
+	}
+
+	memcpy(matrix->csr.offsets, offsets, offsets_size);
+
+	size_t const cols_size = nnz * sizeof *matrix->csr.cols;
+	matrix->csr.cols = state->alloc(cols_size);
+
+	if (matrix->csr.cols == NULL) {
+		goto err_cols;
+	}
+
+	memcpy(matrix->csr.cols, cols, cols_size);
+
+	size_t const data_size = nnz * sizeof *matrix->csr.data;
+	matrix->csr.data = state->alloc(data_size);
+
+	if (matrix->csr.data == NULL) {
+		goto err_data;
+	}
+
+	memset(matrix->csr.data, 0, data_size);
+
+	return 0;
+
+err_data:
+
+	state->free(matrix->csr.cols);
+
+err_cols:
+
+	state->free(matrix->csr.offsets);
+
+err_offsets:
+
+	return -1;
+}
+
+int bfm_matrix_csr_create_shared(bfm_matrix_t* matrix, bfm_state_t* state, size_t m, size_t* offsets, size_t* cols) {
+	matrix_create(matrix, state, BFM_MATRIX_KIND_CSR, BFM_MATRIX_MAJOR_ROW, m);
+
+	size_t const nnz = offsets[m];
+	matrix->csr.nnz = nnz;
+
+	matrix->csr.shared = true;
+	matrix->csr.offsets = offsets;
+	matrix->csr.cols = cols;
+
+	size_t const data_size = nnz * sizeof *matrix->csr.data;
+	matrix->csr.data = state->alloc(data_size);
+
+	if (matrix->csr.data == NULL) {
+		return -1;
+	}
+
+	memset(matrix->csr.data, 0, data_size);
+
+	return 0;
+}
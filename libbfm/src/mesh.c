@@ -1,7 +1,9 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include <bfm/mesh.h>
+#include <bfm/symbolic.h>
 
 int bfm_mesh_create(bfm_mesh_t* mesh, bfm_state_t* state, size_t dim, bfm_elem_kind_t kind) {
 	memset(mesh, 0, sizeof *mesh);
@@ -20,12 +22,110 @@ int bfm_mesh_destroy(bfm_mesh_t* mesh) {
 	state->free(mesh->elems);
 	state->free(mesh->edges);
 
+	state->free(mesh->node_edge_offsets);
+	state->free(mesh->node_edges);
+
 	for (size_t i = 0; i < mesh->n_domains; i++) {
 		bfm_domain_t const domain = mesh->domains[i];
 		state->free(domain.elements);
 	}
 	state->free(mesh->domains);
 
+	state->free(mesh->color_offsets);
+	state->free(mesh->color_elems);
+
+	bfm_symbolic_release(mesh);
+
+	return 0;
+}
+
+// greedy element coloring
+// each node keeps a mask of the colors already used by its elements, and each element takes the first color none of its nodes have
+// elements are visited in order and bucketed stably, so the coloring is deterministic and elements of a color stay sorted
+// meshes needing more than 64 colors (i.e. nodes shared by a silly amount of elements) aren't supported
+
+#define MAX_COLORS 64
+
+int bfm_mesh_color(bfm_mesh_t* mesh) {
+	bfm_state_t* const state = mesh->state;
+	size_t const kind = mesh->kind;
+
+	if (mesh->n_colors || !mesh->n_elems) {
+		return 0;
+	}
+
+	uint64_t* const used = state->alloc(mesh->n_nodes * sizeof *used);
+
+	if (used == NULL) {
+		return -1;
+	}
+
+	memset(used, 0, mesh->n_nodes * sizeof *used);
+
+	uint8_t* const colors = state->alloc(mesh->n_elems * sizeof *colors);
+
+	if (colors == NULL) {
+		state->free(used);
+		return -1;
+	}
+
+	size_t counts[MAX_COLORS + 1] = { 0 };
+	size_t n_colors = 0;
+
+	for (size_t i = 0; i < mesh->n_elems; i++) {
+		size_t const* const elem = &mesh->elems[i * kind];
+		uint64_t taken = 0;
+
+		for (size_t j = 0; j < kind; j++) {
+			taken |= used[elem[j]];
+		}
+
+		if (!~taken) {
+			state->free(used);
+			state->free(colors);
+			return -1;
+		}
+
+		uint8_t const color = __builtin_ctzll(~taken);
+		colors[i] = color;
+		counts[color + 1]++;
+
+		for (size_t j = 0; j < kind; j++) {
+			used[elem[j]] |= 1ull << color;
+		}
+
+		n_colors = BFM_MAX(n_colors, (size_t) color + 1);
+	}
+
+	state->free(used);
+
+	mesh->color_offsets = state->alloc((n_colors + 1) * sizeof *mesh->color_offsets);
+	mesh->color_elems = state->alloc(mesh->n_elems * sizeof *mesh->color_elems);
+
+	if (mesh->color_offsets == NULL || mesh->color_elems == NULL) {
+		state->free(mesh->color_offsets);
+		state->free(mesh->color_elems);
+		state->free(colors);
+
+		mesh->color_offsets = NULL;
+		mesh->color_elems = NULL;
+
+		return -1;
+	}
+
+	for (size_t i = 0; i < n_colors; i++) {
+		counts[i + 1] += counts[i];
+	}
+
+	memcpy(mesh->color_offsets, counts, (n_colors + 1) * sizeof *counts);
+
+	for (size_t i = 0; i < mesh->n_elems; i++) {
+		mesh->color_elems[counts[colors[i]]++] = i;
+	}
+
+	state->free(colors);
+	mesh->n_colors = n_colors;
+
 	return 0;
 }
 
@@ -49,6 +149,63 @@ static int cmp_edge(void const* e1, void const* e2) {
 	return M1 - M2;
 }
 
+// build the node-to-edge adjacency of the mesh, see bfm_mesh_t
+
+static int index_edges(bfm_mesh_t* mesh) {
+	bfm_state_t* const state = mesh->state;
+
+	size_t* const offsets = state->alloc((mesh->n_nodes + 1) * sizeof *offsets);
+
+	if (offsets == NULL) {
+		goto err_offsets_alloc;
+	}
+
+	memset(offsets, 0, (mesh->n_nodes + 1) * sizeof *offsets);
+
+	for (size_t i = 0; i < mesh->n_edges; i++) {
+		bfm_edge_t* const edge = &mesh->edges[i];
+
+		offsets[edge->nodes[0] + 1]++;
+		offsets[edge->nodes[1] + 1]++;
+	}
+
+	for (size_t i = 0; i < mesh->n_nodes; i++) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	size_t* const node_edges = state->alloc(BFM_MAX(offsets[mesh->n_nodes], 1) * sizeof *node_edges);
+
+	if (node_edges == NULL) {
+		goto err_node_edges_alloc;
+	}
+
+	// going through edges in order keeps the edges of each node sorted
+	// offsets[i] is used as the insertion point of node i, ending up as the start of node i + 1, and is shifted back after
+
+	for (size_t i = 0; i < mesh->n_edges; i++) {
+		bfm_edge_t* const edge = &mesh->edges[i];
+
+		node_edges[offsets[edge->nodes[0]]++] = i;
+		node_edges[offsets[edge->nodes[1]]++] = i;
+	}
+
+	memmove(&offsets[1], offsets, mesh->n_nodes * sizeof *offsets);
+	offsets[0] = 0;
+
+	mesh->node_edge_offsets = offsets;
+	mesh->node_edges = node_edges;
+
+	return 0;
+
+err_node_edges_alloc:
+
+	state->free(offsets);
+
+err_offsets_alloc:
+
+	return -1;
+}
+
 static int compute_edges(bfm_mesh_t* mesh) {
 	bfm_state_t* const state = mesh->state;
 
@@ -98,7 +255,7 @@ static int compute_edges(bfm_mesh_t* mesh) {
 		return -1;
 	}
 
-	return 0;
+	return index_edges(mesh);
 }
 
 int bfm_mesh_read_lepl1110(bfm_mesh_t* mesh, bfm_state_t* state, char const* name) {
@@ -107,6 +264,15 @@ int bfm_mesh_read_lepl1110(bfm_mesh_t* mesh, bfm_state_t* state, char const* nam
 	mesh->state = state;
 	mesh->dim = 2; // LEPL1110 only looks at 2D meshes
 
+	mesh->n_colors = 0;
+	mesh->color_offsets = NULL;
+	mesh->color_elems = NULL;
+
+	mesh->symbolic = NULL;
+
+	mesh->node_edge_offsets = NULL;
+	mesh->node_edges = NULL;
+
 	// TODO error messages & more error checking (alloc's/fscanf's)
 
 	FILE* const fp = fopen(name, "r");
@@ -140,6 +306,10 @@ int bfm_mesh_read_lepl1110(bfm_mesh_t* mesh, bfm_state_t* state, char const* nam
 		mesh->edges[i].elems[1] = -1;
 	}
 
+	if (index_edges(mesh) < 0) {
+		goto err_index_edges;
+	}
+
 	// read elements
 
 	char kind_str[16];
@@ -192,6 +362,7 @@ int bfm_mesh_read_lepl1110(bfm_mesh_t* mesh, bfm_state_t* state, char const* nam
 	rv = 0;
 
 err_kind:
+err_index_edges:
 
 	fclose(fp);
 
@@ -18,90 +18,295 @@ int bfm_perm_destroy(bfm_perm_t* perm) {
 	if (perm->has_perm) {
 		state->free(perm->perm);
 		state->free(perm->inv_perm);
+		state->free(perm->visited);
+	}
+
+	if (perm->buf != NULL) {
+		state->free(perm->buf);
 	}
 
 	return 0;
 }
 
-int bfm_perm_perm_matrix(bfm_perm_t* perm, bfm_matrix_t* matrix, bool inv) {
+typedef struct {
+	size_t col;
+	double val;
+} csr_entry_t;
+
+static int cmp_col(void const* _a, void const* _b) {
+	csr_entry_t* const a = (void*) _a;
+	csr_entry_t* const b = (void*) _b;
+
+	return (a->col > b->col) - (a->col < b->col);
+}
+
+// permuting a sparse matrix permutes its sparsity pattern along with it
+// this only needs O(nnz) extra memory, as opposed to the full copy needed for full matrices
+
+static int perm_matrix_csr(bfm_perm_t* perm, bfm_matrix_t* matrix, size_t* cur_perm) {
 	bfm_state_t* const state = perm->state;
+	bfm_matrix_csr_t* const csr = &matrix->csr;
+	size_t const m = matrix->m;
 
-	if (!perm->has_perm) {
+	size_t* const offsets = state->alloc((m + 1) * sizeof *offsets);
+
+	if (offsets == NULL) {
 		return -1;
 	}
 
-	size_t* const cur_perm = inv ? perm->inv_perm : perm->perm;
+	csr_entry_t* const entries = state->alloc(csr->nnz * sizeof *entries);
 
-	if (matrix->m != perm->m) {
+	if (entries == NULL) {
+		state->free(offsets);
 		return -1;
 	}
 
-	if (matrix->kind != BFM_MATRIX_KIND_FULL) {
+	// row i of the old matrix becomes row cur_perm[i] of the new one
+
+	offsets[0] = 0;
+
+	for (size_t i = 0; i < m; i++) {
+		offsets[cur_perm[i] + 1] = csr->offsets[i + 1] - csr->offsets[i];
+	}
+
+	for (size_t i = 0; i < m; i++) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	for (size_t i = 0; i < m; i++) {
+		csr_entry_t* const row = &entries[offsets[cur_perm[i]]];
+
+		for (size_t idx = csr->offsets[i]; idx < csr->offsets[i + 1]; idx++) {
+			row[idx - csr->offsets[i]].col = cur_perm[csr->cols[idx]];
+			row[idx - csr->offsets[i]].val = csr->data[idx];
+		}
+
+		qsort(row, csr->offsets[i + 1] - csr->offsets[i], sizeof *row, cmp_col);
+	}
+
+	// write permuted pattern & values back into matrix
+	// matrices which borrow their pattern get a pattern of their own instead, as the borrowed one mustn't change
+
+	if (csr->shared) {
+		size_t* const cols = state->alloc(csr->nnz * sizeof *cols);
+
+		if (cols == NULL) {
+			state->free(entries);
+			state->free(offsets);
+			return -1;
+		}
+
+		csr->shared = false;
+		csr->offsets = offsets;
+		csr->cols = cols;
+	}
+
+	else {
+		memcpy(csr->offsets, offsets, (m + 1) * sizeof *offsets);
+		state->free(offsets);
+	}
+
+	for (size_t idx = 0; idx < csr->nnz; idx++) {
+		csr->cols[idx] = entries[idx].col;
+		csr->data[idx] = entries[idx].val;
+	}
+
+	state->free(entries);
+
+	return 0;
+}
+
+// make sure the row buffer can hold at least n entries
+// it's kept around so that repeated permutations don't have to allocate anything
+
+static int reserve_buf(bfm_perm_t* perm, size_t n) {
+	bfm_state_t* const state = perm->state;
+
+	if (perm->buf_len >= n) {
+		return 0;
+	}
+
+	double* const buf = state->realloc(perm->buf, n * sizeof *buf);
+
+	if (buf == NULL) {
 		return -1;
 	}
 
-	// copy old matrix to copy from
+	perm->buf = buf;
+	perm->buf_len = n;
+
+	return 0;
+}
+
+// permute the m rows of r entries of an mxr row-major block in place, with row i going to row cur_perm[i]
+// a permutation is a set of disjoint cycles, so follow each of them, carrying the row displaced at each step along to the next
+
+static void perm_rows(bfm_perm_t* perm, size_t* cur_perm, double* data, size_t r) {
+	double* const carry = perm->buf;
+
+	memset(perm->visited, 0, perm->m * sizeof *perm->visited);
+
+	for (size_t start = 0; start < perm->m; start++) {
+		if (perm->visited[start]) {
+			continue;
+		}
+
+		memcpy(carry, &data[start * r], r * sizeof *carry);
+
+		size_t i = start;
+
+		do {
+			i = cur_perm[i];
+			perm->visited[i] = true;
+
+			double* const row = &data[i * r];
+
+			for (size_t q = 0; q < r; q++) {
+				double const tmp = row[q];
+
+				row[q] = carry[q];
+				carry[q] = tmp;
+			}
+		} while (i != start);
+	}
+}
+
+int bfm_perm_perm_matrix(bfm_perm_t* perm, bfm_matrix_t* matrix, bool inv) {
+	if (!perm->has_perm) {
+		return -1;
+	}
 
-	bfm_matrix_t __attribute__((cleanup(bfm_matrix_destroy))) old = {0};
+	size_t* const cur_perm = inv ? perm->inv_perm : perm->perm;
+	size_t const m = matrix->m;
 
-	if (bfm_matrix_full_create(&old, state, matrix->major, matrix->m) < 0) {
+	if (m != perm->m) {
 		return -1;
 	}
 
-	if (bfm_matrix_copy(&old, matrix) < 0) {
+	if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		return perm_matrix_csr(perm, matrix, cur_perm);
+	}
+
+	// band matrices generally don't have the same bandwidth once permuted, so these have to be permuted into a new matrix with bfm_perm_copy_matrix
+
+	if (matrix->kind != BFM_MATRIX_KIND_FULL) {
 		return -1;
 	}
 
-	// actually permute matrix
+	// full matrices are permuted in place, first by row, then by column
+	// PAP^T is the transpose of PA^TP^T, so this works whether the matrix is row- or column-major
 
-	for (size_t i = 0; i < matrix->m; i++) {
-		for (size_t j = 0; j < matrix->m; j++) {
-			size_t const perm_i = cur_perm[i];
-			size_t const perm_j = cur_perm[j];
+	if (reserve_buf(perm, m) < 0) {
+		return -1;
+	}
 
-			double const val = bfm_matrix_get(&old, i, j);
-			bfm_matrix_set(matrix, perm_i, perm_j, val);
-		}
+	double* const data = matrix->full.data;
+	perm_rows(perm, cur_perm, data, m);
+
+	for (size_t i = 0; i < m; i++) {
+		perm_rows(perm, cur_perm, &data[i * m], 1);
 	}
 
 	return 0;
 }
 
 int bfm_perm_perm_vec(bfm_perm_t* perm, bfm_vec_t* vec, bool inv) {
-	bfm_state_t* const state = perm->state;
+	return bfm_perm_perm_rows(perm, vec, 1, inv);
+}
 
+int bfm_perm_perm_rows(bfm_perm_t* perm, bfm_vec_t* vec, size_t r, bool inv) {
 	if (!perm->has_perm) {
 		return -1;
 	}
 
 	size_t* const cur_perm = inv ? perm->inv_perm : perm->perm;
 
-	if (vec->n != perm->m) {
+	if (vec->n != perm->m * r) {
 		return -1;
 	}
 
-	// copy old vector to copy from
+	if (reserve_buf(perm, r) < 0) {
+		return -1;
+	}
 
-	bfm_vec_t __attribute__((cleanup(bfm_vec_destroy))) old = {0};
+	perm_rows(perm, cur_perm, vec->data, r);
+	return 0;
+}
 
-	if (bfm_vec_create(&old, state, vec->n) < 0) {
+int bfm_perm_copy_matrix(bfm_perm_t* perm, bfm_matrix_t* matrix, bfm_matrix_t* src, bool inv) {
+	if (!perm->has_perm) {
 		return -1;
 	}
 
-	if (bfm_vec_copy(&old, vec) < 0) {
+	size_t* const cur_perm = inv ? perm->inv_perm : perm->perm;
+	size_t const m = src->m;
+
+	if (matrix->m != m || m != perm->m) {
 		return -1;
 	}
 
-	// actually permute vec
+	// entry (i, j) of the source matrix goes to entry (cur_perm[i], cur_perm[j])
+	// for sparse matrices, only the entries in the pattern need to be copied over
+
+	if (src->kind == BFM_MATRIX_KIND_CSR) {
+		bfm_matrix_csr_t* const csr = &src->csr;
+
+		for (size_t i = 0; i < m; i++) {
+			for (size_t idx = csr->offsets[i]; idx < csr->offsets[i + 1]; idx++) {
+				if (bfm_matrix_set(matrix, cur_perm[i], cur_perm[csr->cols[idx]], csr->data[idx]) < 0) {
+					return -1;
+				}
+			}
+		}
+
+		return 0;
+	}
 
-	for (size_t i = 0; i < vec->n; i++) {
-		size_t const perm_i = cur_perm[i];
-		vec->data[perm_i] = old.data[i];
+	for (size_t i = 0; i < m; i++) {
+		for (size_t j = 0; j < m; j++) {
+			if (bfm_matrix_set(matrix, cur_perm[i], cur_perm[j], bfm_matrix_get(src, i, j)) < 0) {
+				return -1;
+			}
+		}
 	}
 
 	return 0;
 }
 
+size_t bfm_perm_bandwidth(bfm_perm_t* perm, bfm_matrix_t* matrix) {
+	size_t k = 0;
+
+	if (matrix->kind == BFM_MATRIX_KIND_CSR) {
+		bfm_matrix_csr_t* const csr = &matrix->csr;
+
+		for (size_t i = 0; i < matrix->m; i++) {
+			for (size_t idx = csr->offsets[i]; idx < csr->offsets[i + 1]; idx++) {
+				if (!csr->data[idx]) {
+					continue;
+				}
+
+				ssize_t const diff = perm->perm[i] - perm->perm[csr->cols[idx]];
+				k = BFM_MAX((ssize_t) k, BFM_ABS(diff));
+			}
+		}
+
+		return k;
+	}
+
+	for (size_t i = 0; i < matrix->m; i++) {
+		for (size_t j = 0; j < matrix->m; j++) {
+			if (!bfm_matrix_get(matrix, i, j)) {
+				continue;
+			}
+
+			ssize_t const diff = perm->perm[i] - perm->perm[j];
+			k = BFM_MAX((ssize_t) k, BFM_ABS(diff));
+		}
+	}
+
+	return k;
+}
+
 typedef struct {
 	size_t i;
 	size_t deg;
@@ -111,221 +316,1350 @@ static int cmp_deg(void const* _a, void const* _b) {
 	rcm_node_t* const a = (void*) _a;
 	rcm_node_t* const b = (void*) _b;
 
-	return (int) a->deg - (int) b->deg;
-}
+	// break ties by index so the ordering doesn't depend on the qsort(3) implementation
 
-int bfm_perm_rcm(bfm_perm_t* perm, bfm_matrix_t* A) {
-	int rv = -1;
+	if (a->deg != b->deg) {
+		return (a->deg > b->deg) - (a->deg < b->deg);
+	}
 
-	bfm_state_t* const state = perm->state;
-	size_t const n = A->m;
+	return (a->i > b->i) - (a->i < b->i);
+}
 
-	// permutation object must have the same size as the matrix
+static int alloc_perm(bfm_perm_t* perm) {
+	bfm_state_t* const state = perm->state;
 
-	if (perm->m != n) {
-		goto err_size;
+	if (perm->has_perm) {
+		return 0;
 	}
 
-	// Cuthill-McKee algorithm
-	// start by getting a vector of all the degrees of the nodes in the adjacency matrix
-
-	size_t* const degs = state->alloc(n * sizeof *degs);
+	perm->perm = state->alloc(perm->m * sizeof *perm->perm);
 
-	if (degs == NULL) {
-		goto err_degs_alloc;
+	if (perm->perm == NULL) {
+		goto err_perm_alloc;
 	}
 
-	memset(degs, 0, n * sizeof *degs);
+	perm->inv_perm = state->alloc(perm->m * sizeof *perm->inv_perm);
 
-	for (size_t i = 0; i < n; i++) {
-		for (size_t j = 0; j < n; j++) {
-			degs[i] += !!bfm_matrix_get(A, i, j);
-		}
+	if (perm->inv_perm == NULL) {
+		goto err_inv_perm_alloc;
 	}
 
-	// create a queue of maximum size n for BFS later
-	// we can create only once because it will be emptied on each BFS
-	// we don't need to zero out the queue
-
-	bool* const in_queue = state->alloc(n * sizeof *in_queue);
+	perm->visited = state->alloc(perm->m * sizeof *perm->visited);
 
-	if (in_queue == NULL) {
-		goto err_in_queue_alloc;
+	if (perm->visited == NULL) {
+		goto err_visited_alloc;
 	}
 
-	memset(in_queue, 0, n * sizeof *in_queue);
+	perm->has_perm = true;
+	return 0;
 
-	size_t* const queue = state->alloc(n * sizeof *queue);
+err_visited_alloc:
 
-	if (queue == NULL) {
-		goto err_queue_alloc;
-	}
+	state->free(perm->inv_perm);
 
-	size_t queue_start = 0;
-	size_t queue_end = 0;
+err_inv_perm_alloc:
 
-#define QUEUE_INDEX(i) (queue[(i) % n])
+	state->free(perm->perm);
 
-#define PUSH_QUEUE(val)             \
-	{                                \
-		in_queue[val] = true;         \
-		QUEUE_INDEX(queue_end) = val; \
-		queue_end++;                  \
-	}
+err_perm_alloc:
 
-#define POP_QUEUE(res)                \
-	{                                  \
-		res = QUEUE_INDEX(queue_start); \
-		in_queue[res] = false;          \
-		queue_start++;                  \
-	}
+	return -1;
+}
 
-	// for later, doesn't need to be zeroed out
+// level structures & pseudo-peripheral nodes, shared by the different orderings
+// dist[i] is the distance of node i from the root of the level structure, or UNREACHED
 
-	rcm_node_t* const to_sort = state->alloc(n * sizeof *to_sort);
+#define UNREACHED ((size_t) -1)
+#define DEG(graph, i) ((graph)->offsets[(i) + 1] - (graph)->offsets[i])
 
-	if (to_sort == NULL) {
-		goto err_to_sort_alloc;
-	}
+// BFS from root, which only ever reaches the connected component of root
+// if part is set, only nodes i with part[i] == part[root] are considered to be part of the graph
+// order is filled with the nodes of the component level by level, and their number is returned
 
-	// create map of visited nodes
+static size_t level_structure(bfm_graph_t* graph, size_t root, size_t const* part, size_t* dist, size_t* order) {
+	size_t start = 0;
+	size_t end = 0;
 
-	bool* const visited = state->alloc(n * sizeof *visited);
+	dist[root] = 0;
+	order[end++] = root;
 
-	if (visited == NULL) {
-		goto err_visited_alloc;
-	}
+	while (start != end) {
+		size_t const cur = order[start++];
 
-	memset(visited, 0, n * sizeof *visited);
+		for (size_t j = graph->offsets[cur]; j < graph->offsets[cur + 1]; j++) {
+			size_t const i = graph->neighbours[j];
 
-	// allocate inverse permutation vector
-	// we do this as late as possible to ease error handling
-	// this doesn't need to be zeroed out
+			if (dist[i] != UNREACHED) {
+				continue;
+			}
 
-	perm->inv_perm = state->alloc(n * sizeof *perm->inv_perm);
+			if (part != NULL && part[i] != part[root]) {
+				continue;
+			}
 
-	if (perm->inv_perm == NULL) {
-		goto err_inv_perm_alloc;
+			dist[i] = dist[cur] + 1;
+			order[end++] = i;
+		}
 	}
 
-	// continue while there are still unvisited nodes
-
-	size_t unvisited_count = n;
+	return end;
+}
 
-	for (size_t p = 0; unvisited_count && p < n;) {
-		// find the unvisited node with the smallest degree
-		// min_deg_i is guaranteed to be initialized because at least one of the nodes is unvisited
+static void reset_level_structure(size_t* dist, size_t* order, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		dist[order[i]] = UNREACHED;
+	}
+}
 
-		size_t min_deg = -1;
-		size_t min_deg_i = 0; // XXX we don't care if this is initialized or not, but GCC complains if we don't
+// George-Liu algorithm
+// keep rooting level structures at the smallest-degree node of the last level of the previous one until their depth stops increasing
+// the two ends of the last level structure are a pair of nodes (start & end) which are roughly as far apart as possible
+// on return, dist & order hold the level structure rooted at end, which covers the whole component of root
 
-		for (size_t i = 0; i < n; i++) {
-			if (visited[i]) {
-				continue;
-			}
+static size_t pseudo_peripheral(bfm_graph_t* graph, size_t root, size_t const* part, size_t* dist, size_t* order, size_t* start, size_t* end) {
+	size_t count = level_structure(graph, root, part, dist, order);
+	size_t depth = dist[order[count - 1]];
 
-			// important that this is <= so we get the *last* one!
+	for (;;) {
+		size_t x = order[count - 1];
 
-			if (degs[i] <= min_deg) {
-				min_deg = degs[i];
-				min_deg_i = i;
+		for (size_t i = count; i-- > 0 && dist[order[i]] == depth;) {
+			if (DEG(graph, order[i]) < DEG(graph, x)) {
+				x = order[i];
 			}
 		}
 
-		// BFS starting from unvisited node of smallest degree
+		reset_level_structure(dist, order, count);
+		count = level_structure(graph, x, part, dist, order);
 
-		PUSH_QUEUE(min_deg_i);
+		size_t const x_depth = dist[order[count - 1]];
 
-		while (queue_start != queue_end) {
-			// starting from this node
+		if (x_depth <= depth) {
+			*start = root;
+			*end = x;
 
-			size_t cur;
-			POP_QUEUE(cur);
+			return count;
+		}
 
-			if (!visited[cur]) {
-				visited[cur] = true;
-				unvisited_count--;
-			}
+		root = x;
+		depth = x_depth;
+	}
+}
 
-			// create list of nodes to sort by degree
+// find the unnumbered node with the smallest degree to root the level structures of the next component at
 
-			size_t to_sort_count = 0;
+static size_t min_deg_node(bfm_graph_t* graph, bool* numbered) {
+	size_t min_deg = -1;
+	size_t min_deg_i = 0;
 
-			// visit neighbouring nodes, starting with the smallest degrees
-			// use heapsort(3) to guarantee O(n log n) complexity
+	for (size_t i = 0; i < graph->n; i++) {
+		if (numbered[i]) {
+			continue;
+		}
 
-			for (size_t i = 0; i < n; i++) {
-				if (visited[i]) {
-					continue;
-				}
+		// important that this is <= so we get the *last* one!
 
-				if (!bfm_matrix_get(A, cur, i)) {
-					continue;
-				}
+		if (DEG(graph, i) <= min_deg) {
+			min_deg = DEG(graph, i);
+			min_deg_i = i;
+		}
+	}
 
-				rcm_node_t* const node = &to_sort[to_sort_count++];
+	return min_deg_i;
+}
 
-				node->i = i;
-				node->deg = degs[i];
+int bfm_perm_stats(bfm_perm_t* perm, bfm_graph_t* graph) {
+	if (!perm->has_perm || perm->m != graph->n) {
+		return -1;
+	}
 
-				visited[i] = true;
-			}
+	perm->bandwidth = 0;
+	perm->profile = 0;
 
-			qsort(to_sort, to_sort_count, sizeof *to_sort, cmp_deg);
+	// profile is the sum over all rows of the distance between the diagonal and the leftmost non-zero entry
 
-			// add sorted nodes to queue in order
+	for (size_t row = 0; row < perm->m; row++) {
+		size_t const i = perm->inv_perm[row];
+		size_t first = row;
 
-			for (size_t i = 0; i < to_sort_count; i++) {
-				PUSH_QUEUE(to_sort[i].i);
+		for (size_t j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+			size_t const col = perm->perm[graph->neighbours[j]];
+
+			if (col < first) {
+				first = col;
+			}
+
+			if (col > row && col - row > perm->bandwidth) {
+				perm->bandwidth = col - row;
 			}
+		}
 
-			// add to inverse permutation vector, reversed
+		perm->profile += row - first;
 
-			perm->inv_perm[n - p++ - 1] = cur;
+		if (row - first > perm->bandwidth) {
+			perm->bandwidth = row - first;
 		}
 	}
 
-	// create permutation vector
+	// predicted number of entries of the Cholesky factor, fill included
+	// the entries of row k of L are the nodes of the subtree of the elimination tree spanned by the entries of row k of the renumbered graph
+	// so build up the elimination tree and walk these subtrees at the same time, which is O(nnz(L))
+	// a walk can only ever end on a node without a parent yet, in which case k is its parent
 
-	perm->perm = state->alloc(n * sizeof *perm->perm);
+	bfm_state_t* const state = perm->state;
+	size_t const n = perm->m;
 
-	if (perm->perm == NULL) {
-		state->free(perm->inv_perm);
-		goto err_perm_alloc;
+	size_t* const parent = state->alloc(n * sizeof *parent);
+
+	if (parent == NULL) {
+		return -1;
 	}
 
-	for (size_t i = 0; i < n; i++) {
-		perm->perm[perm->inv_perm[i]] = i;
+	size_t* const mark = state->alloc(n * sizeof *mark);
+
+	if (mark == NULL) {
+		state->free(parent);
+		return -1;
 	}
 
-	// success
+	perm->nnz_l = 0;
 
-	perm->has_perm = true;
-	rv = 0;
+	for (size_t k = 0; k < n; k++) {
+		size_t const i = perm->inv_perm[k];
 
-err_perm_alloc:
-err_inv_perm_alloc:
+		parent[k] = UNREACHED;
+		mark[k] = k;
+		perm->nnz_l++;
 
-	state->free(visited);
+		for (size_t j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+			for (size_t col = perm->perm[graph->neighbours[j]]; col < k && mark[col] != k; col = parent[col]) {
+				mark[col] = k;
+				perm->nnz_l++;
 
-err_visited_alloc:
+				if (parent[col] == UNREACHED) {
+					parent[col] = k;
+				}
+			}
+		}
+	}
 
-	state->free(to_sort);
+	state->free(parent);
+	state->free(mark);
 
-err_to_sort_alloc:
+	return 0;
+}
 
-	state->free(queue);
+int bfm_perm_rcm_graph(bfm_perm_t* perm, bfm_graph_t* graph) {
+	int rv = -1;
 
-err_queue_alloc:
+	bfm_state_t* const state = perm->state;
+	size_t const n = graph->n;
+
+	// permutation object must have the same size as the graph
 
-	state->free(in_queue);
+	if (perm->m != n) {
+		goto err_size;
+	}
 
-err_in_queue_alloc:
+	// Cuthill-McKee algorithm
+	// degrees come straight from the graph offsets, and the neighbours of each node are only ever looked at once, so this is O(nnz) save for the sorting of neighbours by degree
 
-	state->free(degs);
+	size_t max_deg = 0;
 
-err_degs_alloc:
-err_size:
+	for (size_t i = 0; i < n; i++) {
+		if (DEG(graph, i) > max_deg) {
+			max_deg = DEG(graph, i);
+		}
+	}
 
-	return rv;
+	// for later, doesn't need to be zeroed out
+
+	rcm_node_t* const to_sort = state->alloc(max_deg * sizeof *to_sort);
+
+	if (to_sort == NULL && max_deg) {
+		goto err_to_sort_alloc;
+	}
+
+	// create map of visited nodes
+
+	bool* const visited = state->alloc(n * sizeof *visited);
+
+	if (visited == NULL) {
+		goto err_visited_alloc;
+	}
+
+	memset(visited, 0, n * sizeof *visited);
+
+	// each node is queued exactly once (when it's first visited), so the queue is also the Cuthill-McKee ordering itself
+
+	size_t* const queue = state->alloc(n * sizeof *queue);
+
+	if (queue == NULL) {
+		goto err_queue_alloc;
+	}
+
+	size_t queue_start = 0;
+	size_t queue_end = 0;
+
+	// workspace for finding pseudo-peripheral nodes
+
+	size_t* const dist = state->alloc(n * sizeof *dist);
+
+	if (dist == NULL) {
+		goto err_dist_alloc;
+	}
+
+	memset(dist, 0xFF, n * sizeof *dist); // all UNREACHED
+
+	size_t* const order = state->alloc(n * sizeof *order);
+
+	if (order == NULL) {
+		goto err_order_alloc;
+	}
+
+	// continue while there are still unvisited nodes
+
+	while (queue_end < n) {
+		// BFS starting from a pseudo-peripheral node of the next component
+		// this gives much narrower level structures (and thus bands) than starting from its smallest-degree node
+
+		size_t start;
+		size_t end;
+
+		size_t const count = pseudo_peripheral(graph, min_deg_node(graph, visited), NULL, dist, order, &start, &end);
+		reset_level_structure(dist, order, count);
+
+		visited[start] = true;
+		queue[queue_end++] = start;
+
+		while (queue_start != queue_end) {
+			size_t const cur = queue[queue_start++];
+
+			// visit unvisited neighbouring nodes, starting with the smallest degrees
+
+			size_t to_sort_count = 0;
+
+			for (size_t j = graph->offsets[cur]; j < graph->offsets[cur + 1]; j++) {
+				size_t const i = graph->neighbours[j];
+
+				if (visited[i]) {
+					continue;
+				}
+
+				rcm_node_t* const node = &to_sort[to_sort_count++];
+
+				node->i = i;
+				node->deg = DEG(graph, i);
+
+				visited[i] = true;
+			}
+
+			qsort(to_sort, to_sort_count, sizeof *to_sort, cmp_deg);
+
+			for (size_t i = 0; i < to_sort_count; i++) {
+				queue[queue_end++] = to_sort[i].i;
+			}
+		}
+	}
+
+	// reverse the ordering to get the inverse permutation vector, and create the permutation vector from that
+
+	if (alloc_perm(perm) < 0) {
+		goto err_perm_alloc;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		perm->inv_perm[n - i - 1] = queue[i];
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		perm->perm[perm->inv_perm[i]] = i;
+	}
+
+	// success
+
+	rv = bfm_perm_stats(perm, graph);
+
+err_perm_alloc:
+
+	state->free(order);
+
+err_order_alloc:
+
+	state->free(dist);
+
+err_dist_alloc:
+
+	state->free(queue);
+
+err_queue_alloc:
+
+	state->free(visited);
+
+err_visited_alloc:
+
+	state->free(to_sort);
+
+err_to_sort_alloc:
+err_size:
+
+	return rv;
+}
+
+// Sloan algorithm
+// nodes are numbered in order of priority, which favours nodes far from the end node (global term) and nodes whose numbering grows the front the least (local term)
+// priorities only ever increase, so they're kept in an indexed binary max-heap
+
+#define SLOAN_W1 1 // weight of the distance to the end node
+#define SLOAN_W2 2 // weight of the current degree
+
+typedef enum {
+	SLOAN_INACTIVE = 0,
+	SLOAN_PREACTIVE,  // adjacent to an active or postactive node
+	SLOAN_ACTIVE,     // adjacent to a postactive node, i.e. in the front
+	SLOAN_POSTACTIVE, // numbered
+} sloan_status_t;
+
+typedef struct {
+	size_t size;
+	size_t* nodes;
+	size_t* pos;
+	ssize_t* prio;
+} sloan_heap_t;
+
+static bool heap_above(sloan_heap_t* heap, size_t a, size_t b) {
+	if (heap->prio[a] != heap->prio[b]) {
+		return heap->prio[a] > heap->prio[b];
+	}
+
+	return a < b;
+}
+
+static void heap_swap(sloan_heap_t* heap, size_t a, size_t b) {
+	size_t const tmp = heap->nodes[a];
+
+	heap->nodes[a] = heap->nodes[b];
+	heap->nodes[b] = tmp;
+
+	heap->pos[heap->nodes[a]] = a;
+	heap->pos[heap->nodes[b]] = b;
+}
+
+static void heap_up(sloan_heap_t* heap, size_t k) {
+	while (k > 0 && heap_above(heap, heap->nodes[k], heap->nodes[(k - 1) / 2])) {
+		heap_swap(heap, k, (k - 1) / 2);
+		k = (k - 1) / 2;
+	}
+}
+
+static void heap_down(sloan_heap_t* heap, size_t k) {
+	for (;;) {
+		size_t top = k;
+
+		for (size_t c = 2 * k + 1; c <= 2 * k + 2 && c < heap->size; c++) {
+			if (heap_above(heap, heap->nodes[c], heap->nodes[top])) {
+				top = c;
+			}
+		}
+
+		if (top == k) {
+			return;
+		}
+
+		heap_swap(heap, k, top);
+		k = top;
+	}
+}
+
+static void heap_push(sloan_heap_t* heap, size_t i) {
+	heap->pos[i] = heap->size;
+	heap->nodes[heap->size++] = i;
+
+	heap_up(heap, heap->size - 1);
+}
+
+static size_t heap_pop(sloan_heap_t* heap) {
+	size_t const top = heap->nodes[0];
+
+	heap->nodes[0] = heap->nodes[--heap->size];
+	heap->pos[heap->nodes[0]] = 0;
+
+	heap_down(heap, 0);
+
+	return top;
+}
+
+// increase priority of node i, and make it preactive (& queue it) if it was inactive
+
+static void sloan_raise(sloan_heap_t* heap, sloan_status_t* status, size_t i) {
+	heap->prio[i] += SLOAN_W2;
+
+	if (status[i] == SLOAN_INACTIVE) {
+		status[i] = SLOAN_PREACTIVE;
+		heap_push(heap, i);
+	}
+
+	else {
+		heap_up(heap, heap->pos[i]);
+	}
+}
+
+int bfm_perm_sloan(bfm_perm_t* perm, bfm_graph_t* graph) {
+	int rv = -1;
+
+	bfm_state_t* const state = perm->state;
+	size_t const n = graph->n;
+
+	// permutation object must have the same size as the graph
+
+	if (perm->m != n) {
+		goto err_size;
+	}
+
+	sloan_status_t* const status = state->alloc(n * sizeof *status);
+
+	if (status == NULL) {
+		goto err_status_alloc;
+	}
+
+	memset(status, 0, n * sizeof *status); // all SLOAN_INACTIVE
+
+	// workspace for finding pseudo-peripheral nodes
+
+	size_t* const dist = state->alloc(n * sizeof *dist);
+
+	if (dist == NULL) {
+		goto err_dist_alloc;
+	}
+
+	memset(dist, 0xFF, n * sizeof *dist); // all UNREACHED
+
+	size_t* const order = state->alloc(n * sizeof *order);
+
+	if (order == NULL) {
+		goto err_order_alloc;
+	}
+
+	// priority queue
+
+	sloan_heap_t heap = {
+		.size = 0,
+		.nodes = state->alloc(n * sizeof *heap.nodes),
+		.pos = state->alloc(n * sizeof *heap.pos),
+		.prio = state->alloc(n * sizeof *heap.prio),
+	};
+
+	if (heap.nodes == NULL || heap.pos == NULL || heap.prio == NULL) {
+		goto err_heap_alloc;
+	}
+
+	if (alloc_perm(perm) < 0) {
+		goto err_perm_alloc;
+	}
+
+	// number each component in turn
+
+	size_t numbered = 0;
+
+	while (numbered < n) {
+		size_t start;
+		size_t end;
+
+		// no node of the components left is in SLOAN_INACTIVE state
+
+		size_t root = 0;
+		size_t min_deg = -1;
+
+		for (size_t i = 0; i < n; i++) {
+			if (status[i] == SLOAN_INACTIVE && DEG(graph, i) <= min_deg) {
+				min_deg = DEG(graph, i);
+				root = i;
+			}
+		}
+
+		size_t const count = pseudo_peripheral(graph, root, NULL, dist, order, &start, &end);
+
+		// initial priorities, from the distances to the end node left over by the search for it
+		// the degree of a node doesn't count the node itself
+
+		for (size_t k = 0; k < count; k++) {
+			size_t const i = order[k];
+			ssize_t deg = 0;
+
+			for (size_t j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+				deg += graph->neighbours[j] != i;
+			}
+
+			heap.prio[i] = SLOAN_W1 * (ssize_t) dist[i] - SLOAN_W2 * (deg + 1);
+		}
+
+		reset_level_structure(dist, order, count);
+
+		status[start] = SLOAN_PREACTIVE;
+		heap_push(&heap, start);
+
+		while (heap.size) {
+			size_t const i = heap_pop(&heap);
+
+			// a preactive node being numbered makes all its neighbours part of the front
+
+			if (status[i] == SLOAN_PREACTIVE) {
+				for (size_t j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+					size_t const nb = graph->neighbours[j];
+
+					if (nb != i && status[nb] != SLOAN_POSTACTIVE) {
+						sloan_raise(&heap, status, nb);
+					}
+				}
+			}
+
+			status[i] = SLOAN_POSTACTIVE;
+			perm->inv_perm[numbered++] = i;
+
+			// preactive neighbours become active, and their own neighbours preactive
+
+			for (size_t j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+				size_t const nb = graph->neighbours[j];
+
+				if (status[nb] != SLOAN_PREACTIVE) {
+					continue;
+				}
+
+				status[nb] = SLOAN_ACTIVE;
+				sloan_raise(&heap, status, nb);
+
+				for (size_t k = graph->offsets[nb]; k < graph->offsets[nb + 1]; k++) {
+					size_t const nb_nb = graph->neighbours[k];
+
+					if (nb_nb != nb && status[nb_nb] != SLOAN_POSTACTIVE) {
+						sloan_raise(&heap, status, nb_nb);
+					}
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		perm->perm[perm->inv_perm[i]] = i;
+	}
+
+	// success
+
+	rv = bfm_perm_stats(perm, graph);
+
+err_perm_alloc:
+err_heap_alloc:
+
+	state->free(heap.nodes);
+	state->free(heap.pos);
+	state->free(heap.prio);
+
+	state->free(order);
+
+err_order_alloc:
+
+	state->free(dist);
+
+err_dist_alloc:
+
+	state->free(status);
+
+err_status_alloc:
+err_size:
+
+	return rv;
+}
+
+// nested dissection
+// split each part of the graph in two halves with a small separator, dissect both halves recursively, and number the separator last
+// separators are the middle level of a level structure rooted at a pseudo-peripheral node, which for meshes means a cut across their narrowest direction
+// a factorization then only fills in within halves & separators, which for 2D meshes brings nnz(L) down to O(n log n)
+
+#define ND_LEAF 16 // parts this small aren't dissected any further
+
+typedef struct {
+	bfm_graph_t* graph;
+	bfm_perm_t* perm;
+
+	// part[i] is the part node i belongs to, or UNREACHED if it's been set aside for numbering already
+
+	size_t* part;
+	size_t next_part;
+
+	size_t* dist;
+	size_t* order;
+
+	size_t numbered;
+} nd_t;
+
+static void nd_number(nd_t* nd, size_t* nodes, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		nd->perm->inv_perm[nd->numbered++] = nodes[i];
+		nd->part[nodes[i]] = UNREACHED;
+	}
+}
+
+static void nd_dissect(nd_t* nd, size_t* nodes, size_t count) {
+	while (count > ND_LEAF) {
+		size_t start;
+		size_t end;
+
+		size_t const reached = pseudo_peripheral(nd->graph, nodes[0], nd->part, nd->dist, nd->order, &start, &end);
+
+		// part is disconnected: move the component of nodes[0] to the front & dissect it on its own
+		// then keep going with the rest of the part
+
+		if (reached < count) {
+			size_t const part = nd->next_part++;
+
+			for (size_t k = 0; k < reached; k++) {
+				nd->part[nd->order[k]] = part;
+			}
+
+			reset_level_structure(nd->dist, nd->order, reached);
+
+			for (size_t i = 0, front = 0; i < count; i++) {
+				if (nd->part[nodes[i]] == part) {
+					size_t const tmp = nodes[front];
+
+					nodes[front++] = nodes[i];
+					nodes[i] = tmp;
+				}
+			}
+
+			nd_dissect(nd, nodes, reached);
+
+			nodes += reached;
+			count -= reached;
+
+			continue;
+		}
+
+		// too shallow to be split
+
+		size_t const depth = nd->dist[nd->order[count - 1]];
+
+		if (depth < 2) {
+			reset_level_structure(nd->dist, nd->order, count);
+			break;
+		}
+
+		// separator is the level splitting the part in two halves of roughly the same size
+		// nodes of that level which aren't adjacent to the next one can be moved to the first half
+
+		size_t level = nd->dist[nd->order[count / 2]];
+		level = BFM_MAX(level, 1);
+		level = BFM_MIN(level, depth - 1);
+
+		size_t const part_a = nd->next_part++;
+		size_t const part_b = nd->next_part++;
+
+		size_t count_a = 0;
+		size_t count_b = 0;
+
+		for (size_t k = 0; k < count; k++) {
+			size_t const i = nd->order[k];
+			size_t const dist = nd->dist[i];
+
+			if (dist > level) {
+				nd->part[i] = part_b;
+				count_b++;
+
+				continue;
+			}
+
+			nd->part[i] = part_a;
+
+			if (dist < level) {
+				count_a++;
+				continue;
+			}
+
+			for (size_t j = nd->graph->offsets[i]; j < nd->graph->offsets[i + 1]; j++) {
+				if (nd->dist[nd->graph->neighbours[j]] == level + 1) {
+					nd->part[i] = UNREACHED;
+					break;
+				}
+			}
+
+			count_a += nd->part[i] == part_a;
+		}
+
+		// lay nodes out as first half, second half, separator
+
+		size_t cur_a = 0;
+		size_t cur_b = count_a;
+		size_t cur_sep = count_a + count_b;
+
+		for (size_t k = 0; k < count; k++) {
+			size_t const i = nd->order[k];
+
+			if (nd->part[i] == part_a) {
+				nodes[cur_a++] = i;
+			}
+
+			else if (nd->part[i] == part_b) {
+				nodes[cur_b++] = i;
+			}
+
+			else {
+				nodes[cur_sep++] = i;
+			}
+		}
+
+		reset_level_structure(nd->dist, nd->order, count);
+
+		nd_dissect(nd, nodes, count_a);
+		nd_dissect(nd, nodes + count_a, count_b);
+		nd_number(nd, nodes + count_a + count_b, count - count_a - count_b);
+
+		return;
+	}
+
+	nd_number(nd, nodes, count);
+}
+
+int bfm_perm_nd(bfm_perm_t* perm, bfm_graph_t* graph) {
+	int rv = -1;
+
+	bfm_state_t* const state = perm->state;
+	size_t const n = graph->n;
+
+	// permutation object must have the same size as the graph
+
+	if (perm->m != n) {
+		goto err_size;
+	}
+
+	nd_t nd = {
+		.graph = graph,
+		.perm = perm,
+		.next_part = 1,
+		.numbered = 0,
+	};
+
+	nd.part = state->alloc(n * sizeof *nd.part);
+
+	if (nd.part == NULL) {
+		goto err_part_alloc;
+	}
+
+	memset(nd.part, 0, n * sizeof *nd.part); // all in part 0
+
+	// workspace for finding pseudo-peripheral nodes
+
+	nd.dist = state->alloc(n * sizeof *nd.dist);
+
+	if (nd.dist == NULL) {
+		goto err_dist_alloc;
+	}
+
+	memset(nd.dist, 0xFF, n * sizeof *nd.dist); // all UNREACHED
+
+	nd.order = state->alloc(n * sizeof *nd.order);
+
+	if (nd.order == NULL) {
+		goto err_order_alloc;
+	}
+
+	// nodes of each part are kept contiguous in here
+
+	size_t* const nodes = state->alloc(n * sizeof *nodes);
+
+	if (nodes == NULL) {
+		goto err_nodes_alloc;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		nodes[i] = i;
+	}
+
+	if (alloc_perm(perm) < 0) {
+		goto err_perm_alloc;
+	}
+
+	nd_dissect(&nd, nodes, n);
+
+	for (size_t i = 0; i < n; i++) {
+		perm->perm[perm->inv_perm[i]] = i;
+	}
+
+	// success
+
+	rv = bfm_perm_stats(perm, graph);
+
+err_perm_alloc:
+
+	state->free(nodes);
+
+err_nodes_alloc:
+
+	state->free(nd.order);
+
+err_order_alloc:
+
+	state->free(nd.dist);
+
+err_dist_alloc:
+
+	state->free(nd.part);
+
+err_part_alloc:
+err_size:
+
+	return rv;
+}
+
+// approximate minimum degree
+// eliminate the node of smallest degree first, as it creates the least fill, but on a quotient graph so that fill never has to be formed explicitly
+// each eliminated node p becomes an element, standing for the clique formed by its remaining neighbours (the variables of L_p)
+// each variable i is adjacent to some other variables (A_i) and to some elements (E_i), and its degree is bounded by |A_i| + sum over E_i of |L_e| instead of being computed exactly
+// nodes are eliminated one by one, without detecting indistinguishable nodes, which is fine as graphs are of mesh nodes rather than DOFs
+
+typedef struct {
+	size_t len;
+	size_t cap;
+	size_t* data;
+} amd_list_t;
+
+static int amd_push(bfm_state_t* state, amd_list_t* list, size_t val) {
+	if (list->len == list->cap) {
+		size_t const cap = list->cap ? list->cap * 2 : 4;
+		size_t* const data = state->realloc(list->data, cap * sizeof *data);
+
+		if (data == NULL) {
+			return -1;
+		}
+
+		list->cap = cap;
+		list->data = data;
+	}
+
+	list->data[list->len++] = val;
+	return 0;
+}
+
+static void amd_free(bfm_state_t* state, amd_list_t* list) {
+	state->free(list->data);
+	memset(list, 0, sizeof *list);
+}
+
+// variables are kept in doubly-linked lists (buckets) by degree, so that the one of smallest degree can be found quickly
+
+typedef struct {
+	size_t* head;
+	size_t* next;
+	size_t* prev;
+	size_t* deg;
+} amd_buckets_t;
+
+static void bucket_insert(amd_buckets_t* buckets, size_t i, size_t deg) {
+	buckets->deg[i] = deg;
+	buckets->prev[i] = UNREACHED;
+	buckets->next[i] = buckets->head[deg];
+
+	if (buckets->head[deg] != UNREACHED) {
+		buckets->prev[buckets->head[deg]] = i;
+	}
+
+	buckets->head[deg] = i;
+}
+
+static void bucket_remove(amd_buckets_t* buckets, size_t i) {
+	if (buckets->prev[i] != UNREACHED) {
+		buckets->next[buckets->prev[i]] = buckets->next[i];
+	}
+
+	else {
+		buckets->head[buckets->deg[i]] = buckets->next[i];
+	}
+
+	if (buckets->next[i] != UNREACHED) {
+		buckets->prev[buckets->next[i]] = buckets->prev[i];
+	}
+}
+
+int bfm_perm_amd(bfm_perm_t* perm, bfm_graph_t* graph) {
+	int rv = -1;
+
+	bfm_state_t* const state = perm->state;
+	size_t const n = graph->n;
+
+	// permutation object must have the same size as the graph
+
+	if (perm->m != n) {
+		goto err_size;
+	}
+
+	// A_i, E_i & L_e for each variable/element
+	// element e is the eliminated node e, so these can all be indexed by node
+
+	amd_list_t* const vars = state->alloc(n * sizeof *vars);
+
+	if (vars == NULL) {
+		goto err_vars_alloc;
+	}
+
+	memset(vars, 0, n * sizeof *vars);
+
+	amd_list_t* const elems = state->alloc(n * sizeof *elems);
+
+	if (elems == NULL) {
+		goto err_elems_alloc;
+	}
+
+	memset(elems, 0, n * sizeof *elems);
+
+	amd_list_t* const members = state->alloc(n * sizeof *members);
+
+	if (members == NULL) {
+		goto err_members_alloc;
+	}
+
+	memset(members, 0, n * sizeof *members);
+
+	// eliminated[i] is set once node i is an element, absorbed[e] once element e is absorbed into another one
+	// mark[i] == k + 1 if variable i is in L_p at step k, w_mark[e] == k + 1 if w[e] = |L_e \ L_p| has been computed at step k
+
+	bool* const eliminated = state->alloc(n * sizeof *eliminated);
+
+	if (eliminated == NULL) {
+		goto err_eliminated_alloc;
+	}
+
+	memset(eliminated, 0, n * sizeof *eliminated);
+
+	bool* const absorbed = state->alloc(n * sizeof *absorbed);
+
+	if (absorbed == NULL) {
+		goto err_absorbed_alloc;
+	}
+
+	memset(absorbed, 0, n * sizeof *absorbed);
+
+	size_t* const mark = state->alloc(n * sizeof *mark);
+
+	if (mark == NULL) {
+		goto err_mark_alloc;
+	}
+
+	memset(mark, 0, n * sizeof *mark);
+
+	size_t* const w_mark = state->alloc(n * sizeof *w_mark);
+
+	if (w_mark == NULL) {
+		goto err_w_mark_alloc;
+	}
+
+	memset(w_mark, 0, n * sizeof *w_mark);
+
+	size_t* const w = state->alloc(n * sizeof *w);
+
+	if (w == NULL) {
+		goto err_w_alloc;
+	}
+
+	amd_buckets_t buckets = {
+		.head = state->alloc(n * sizeof *buckets.head),
+		.next = state->alloc(n * sizeof *buckets.next),
+		.prev = state->alloc(n * sizeof *buckets.prev),
+		.deg = state->alloc(n * sizeof *buckets.deg),
+	};
+
+	if (buckets.head == NULL || buckets.next == NULL || buckets.prev == NULL || buckets.deg == NULL) {
+		goto err_buckets_alloc;
+	}
+
+	if (alloc_perm(perm) < 0) {
+		goto err_perm_alloc;
+	}
+
+	// initially, there are no elements and A_i is just the neighbours of i
+
+	memset(buckets.head, 0xFF, n * sizeof *buckets.head); // all UNREACHED
+
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+			if (graph->neighbours[j] != i && amd_push(state, &vars[i], graph->neighbours[j]) < 0) {
+				goto err_list_alloc;
+			}
+		}
+
+		bucket_insert(&buckets, i, vars[i].len);
+	}
+
+	size_t min_deg = 0;
+
+	for (size_t k = 0; k < n; k++) {
+		size_t const stamp = k + 1;
+
+		// pick variable of smallest degree to eliminate
+
+		while (buckets.head[min_deg] == UNREACHED) {
+			min_deg++;
+		}
+
+		size_t const p = buckets.head[min_deg];
+
+		bucket_remove(&buckets, p);
+		eliminated[p] = true;
+		perm->inv_perm[k] = p;
+
+		// L_p is made of the variables adjacent to p, either directly or through the elements adjacent to p
+		// those elements are all contained in L_p, so they're absorbed into it
+
+		amd_list_t* const l_p = &members[p];
+
+		for (size_t j = 0; j < vars[p].len; j++) {
+			size_t const i = vars[p].data[j];
+
+			if (mark[i] != stamp) {
+				mark[i] = stamp;
+
+				if (amd_push(state, l_p, i) < 0) {
+					goto err_list_alloc;
+				}
+			}
+		}
+
+		for (size_t j = 0; j < elems[p].len; j++) {
+			size_t const e = elems[p].data[j];
+
+			for (size_t l = 0; l < members[e].len; l++) {
+				size_t const i = members[e].data[l];
+
+				if (i != p && mark[i] != stamp) {
+					mark[i] = stamp;
+
+					if (amd_push(state, l_p, i) < 0) {
+						goto err_list_alloc;
+					}
+				}
+			}
+
+			absorbed[e] = true;
+			amd_free(state, &members[e]);
+		}
+
+		amd_free(state, &vars[p]);
+		amd_free(state, &elems[p]);
+
+		// p is now an element adjacent to all the variables of L_p
+		// variables of L_p are adjacent through p, so they don't need to be in each other's A_i anymore
+
+		for (size_t j = 0; j < l_p->len; j++) {
+			size_t const i = l_p->data[j];
+			amd_list_t* const vars_i = &vars[i];
+
+			size_t len = 0;
+
+			for (size_t l = 0; l < vars_i->len; l++) {
+				size_t const var = vars_i->data[l];
+
+				if (var != p && mark[var] != stamp) {
+					vars_i->data[len++] = var;
+				}
+			}
+
+			vars_i->len = len;
+
+			if (amd_push(state, &elems[i], p) < 0) {
+				goto err_list_alloc;
+			}
+		}
+
+		// w[e] = |L_e \ L_p| for every other element adjacent to a variable of L_p
+
+		for (size_t j = 0; j < l_p->len; j++) {
+			size_t const i = l_p->data[j];
+
+			for (size_t l = 0; l < elems[i].len; l++) {
+				size_t const e = elems[i].data[l];
+
+				if (e == p || absorbed[e]) {
+					continue;
+				}
+
+				if (w_mark[e] != stamp) {
+					w_mark[e] = stamp;
+					w[e] = members[e].len;
+				}
+
+				w[e]--;
+			}
+		}
+
+		// approximate degrees of the variables of L_p
+		// elements whose variables are all in L_p can be absorbed into p (aggressive absorption)
+
+		size_t const remaining = n - k - 1;
+
+		for (size_t j = 0; j < l_p->len; j++) {
+			size_t const i = l_p->data[j];
+			amd_list_t* const elems_i = &elems[i];
+
+			size_t deg = vars[i].len + l_p->len - 1;
+			size_t len = 0;
+
+			for (size_t l = 0; l < elems_i->len; l++) {
+				size_t const e = elems_i->data[l];
+
+				if (absorbed[e]) {
+					continue;
+				}
+
+				if (e != p && w[e] == 0) {
+					absorbed[e] = true;
+					amd_free(state, &members[e]);
+
+					continue;
+				}
+
+				if (e != p) {
+					deg += w[e];
+				}
+
+				elems_i->data[len++] = e;
+			}
+
+			elems_i->len = len;
+
+			deg = BFM_MIN(deg, buckets.deg[i] + l_p->len - 1);
+			deg = BFM_MIN(deg, remaining - 1);
+
+			bucket_remove(&buckets, i);
+			bucket_insert(&buckets, i, deg);
+
+			min_deg = BFM_MIN(min_deg, deg);
+		}
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		perm->perm[perm->inv_perm[i]] = i;
+	}
+
+	// success
+
+	rv = bfm_perm_stats(perm, graph);
+
+err_list_alloc:
+err_perm_alloc:
+err_buckets_alloc:
+
+	state->free(buckets.head);
+	state->free(buckets.next);
+	state->free(buckets.prev);
+	state->free(buckets.deg);
+
+	state->free(w);
+
+err_w_alloc:
+
+	state->free(w_mark);
+
+err_w_mark_alloc:
+
+	state->free(mark);
+
+err_mark_alloc:
+
+	state->free(absorbed);
+
+err_absorbed_alloc:
+
+	state->free(eliminated);
+
+err_eliminated_alloc:
+
+	for (size_t i = 0; i < n; i++) {
+		amd_free(state, &members[i]);
+	}
+
+	state->free(members);
+
+err_members_alloc:
+
+	for (size_t i = 0; i < n; i++) {
+		amd_free(state, &elems[i]);
+	}
+
+	state->free(elems);
+
+err_elems_alloc:
+
+	for (size_t i = 0; i < n; i++) {
+		amd_free(state, &vars[i]);
+	}
+
+	state->free(vars);
+
+err_vars_alloc:
+err_size:
+
+	return rv;
+}
+
+int bfm_perm_order(bfm_perm_t* perm, bfm_graph_t* graph, bfm_perm_kind_t kind) {
+	if (kind == BFM_PERM_KIND_RCM) {
+		return bfm_perm_rcm_graph(perm, graph);
+	}
+
+	if (kind == BFM_PERM_KIND_SLOAN) {
+		return bfm_perm_sloan(perm, graph);
+	}
+
+	if (kind == BFM_PERM_KIND_ND) {
+		return bfm_perm_nd(perm, graph);
+	}
+
+	if (kind == BFM_PERM_KIND_AMD) {
+		return bfm_perm_amd(perm, graph);
+	}
+
+	return -1;
+}
+
+int bfm_perm_rcm(bfm_perm_t* perm, bfm_matrix_t* A) {
+	bfm_graph_t graph;
+
+	if (bfm_graph_create_matrix(&graph, perm->state, A) < 0) {
+		return -1;
+	}
+
+	int const rv = bfm_perm_rcm_graph(perm, &graph);
+	bfm_graph_destroy(&graph);
+
+	return rv;
+}
+
+int bfm_perm_expand(bfm_perm_t* perm, bfm_perm_t* src, size_t dim) {
+	if (!src->has_perm || perm->m != src->m * dim) {
+		return -1;
+	}
+
+	if (alloc_perm(perm) < 0) {
+		return -1;
+	}
+
+	// node i goes to position perm[i], so its DOF i*dim+p goes to position perm[i]*dim+p
+	// this keeps the DOFs of a node contiguous, which the element matrices are built around
+
+	for (size_t i = 0; i < src->m; i++) {
+		for (size_t p = 0; p < dim; p++) {
+			perm->perm[i * dim + p] = src->perm[i] * dim + p;
+			perm->inv_perm[i * dim + p] = src->inv_perm[i] * dim + p;
+		}
+	}
+
+	// the stats follow from those of the node permutation
+	// each node's row becomes dim rows, its band dim times wider, and the leftmost entry of row p of a node is p entries further out
+
+	perm->bandwidth = (src->bandwidth + 1) * dim - 1;
+	perm->profile = dim * dim * src->profile + src->m * dim * (dim - 1) / 2;
+
+	// likewise, each column of L becomes dim columns, the p-th of which has all the rows of the original column but p
+
+	perm->nnz_l = dim * dim * src->nnz_l - src->m * dim * (dim - 1) / 2;
+
+	return 0;
 }
@@ -82,6 +82,66 @@ int bfm_rule_destroy(bfm_rule_t* rule) {
 	state->free(rule->points);
 	bfm_shape_destroy(&rule->shape);
 
+	state->free(rule->phi);
+	state->free(rule->dphi_dxsi);
+	state->free(rule->dphi_deta);
+
+	return 0;
+}
+
+int bfm_rule_tabulate(bfm_rule_t* rule) {
+	bfm_state_t* const state = rule->state;
+	bfm_shape_t* const shape = &rule->shape;
+
+	if (rule->dim != 2) {
+		return -1;
+	}
+
+	rule->tabulated = false;
+
+	size_t const size = rule->n_points * rule->kind * sizeof *rule->phi;
+
+	double* const phi = state->realloc(rule->phi, size);
+
+	if (phi == NULL) {
+		return -1;
+	}
+
+	rule->phi = phi;
+
+	double* const dphi_dxsi = state->realloc(rule->dphi_dxsi, size);
+
+	if (dphi_dxsi == NULL) {
+		return -1;
+	}
+
+	rule->dphi_dxsi = dphi_dxsi;
+
+	double* const dphi_deta = state->realloc(rule->dphi_deta, size);
+
+	if (dphi_deta == NULL) {
+		return -1;
+	}
+
+	rule->dphi_deta = dphi_deta;
+
+	for (size_t i = 0; i < rule->n_points; i++) {
+		size_t const offset = i * rule->kind;
+
+		if (shape->phi(shape, rule->points[i], &phi[offset]) < 0) {
+			return -1;
+		}
+
+		if (shape->dphi(shape, 0, rule->points[i], &dphi_dxsi[offset]) < 0) {
+			return -1;
+		}
+
+		if (shape->dphi(shape, 1, rule->points[i], &dphi_deta[offset]) < 0) {
+			return -1;
+		}
+	}
+
+	rule->tabulated = true;
 	return 0;
 }
 
@@ -147,5 +207,12 @@ int bfm_rule_create_gauss_legendre(bfm_rule_t* rule, bfm_state_t* state, size_t
 		}
 	}
 
+	// points are fixed from here on, so tabulate shape functions straight away
+
+	if (bfm_rule_tabulate(rule) < 0) {
+		bfm_rule_destroy(rule);
+		return -1;
+	}
+
 	return 0;
 }
@@ -11,6 +11,10 @@ int bfm_sim_create(bfm_sim_t* sim, bfm_state_t* state, bfm_sim_kind_t kind) {
 	sim->state = state;
 	sim->kind = kind;
 
+	sim->solver = BFM_SIM_SOLVER_DIRECT;
+	bfm_pcg_default(&sim->pcg);
+	sim->ordering = BFM_PERM_KIND_RCM;
+
 	return 0;
 }
 
@@ -96,60 +100,542 @@ int bfm_sim_add_force(bfm_sim_t* sim, bfm_force_t* force) {
 	return 0;
 }
 
+int bfm_sim_set_solver(bfm_sim_t* sim, bfm_sim_solver_t solver) {
+	sim->solver = solver;
+	sim->ordering = solver == BFM_SIM_SOLVER_SPARSE ? BFM_PERM_KIND_AMD : BFM_PERM_KIND_RCM;
+
+	return 0;
+}
+
+int bfm_sim_set_pcg(bfm_sim_t* sim, bfm_precond_kind_t precond, double tol, size_t max_iter) {
+	sim->pcg.precond = precond;
+	sim->pcg.tol = tol;
+	sim->pcg.max_iter = max_iter;
+
+	return 0;
+}
+
+int bfm_sim_set_ordering(bfm_sim_t* sim, bfm_perm_kind_t ordering) {
+	sim->ordering = ordering;
+	return 0;
+}
+
 // simulation run functions per kind
 
-typedef int (*system_create_elasticity_fn_t)(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces);
+typedef int (*system_create_elasticity_fn_t)(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bfm_system_layout_t const* layout);
+
+static void set_effects(bfm_instance_t* instance, bfm_vec_t* vec) {
+	bfm_mesh_t* const mesh = instance->obj->mesh;
+	size_t const dim = mesh->dim;
+
+	for (size_t j = 0; j < mesh->n_nodes; j++) {
+		for (size_t k = 0; k < dim; k++) {
+			instance->effects[j * dim + k] = vec->data[j * dim + k];
+		}
+	}
+}
+
+// layout to assemble systems in, given how they'll be solved
+// systems going through the band factorization are assembled straight into a band matrix in the renumbered order (see attach_and_factorize for which ones do)
+// only planar systems are symmetric, and only those can be solved with the sparse & iterative solvers, which need A to be assembled sparse
+
+static void system_layout(bfm_sim_t* sim, bool solve_pcg, bfm_system_layout_t* layout) {
+	bool const symmetric = sim->kind != BFM_SIM_KIND_AXISYMMETRIC_STRAIN;
+
+	layout->band = !symmetric || sim->solver == BFM_SIM_SOLVER_DIRECT || (sim->solver == BFM_SIM_SOLVER_PCG && !solve_pcg);
+	layout->ordering = sim->solver == BFM_SIM_SOLVER_SPARSE ? BFM_PERM_KIND_RCM : sim->ordering;
+}
+
+// attach system to instance and factorize it
+// this is done before factorizing so it's cleaned up along with the instance on error
+
+static int attach_and_factorize(bfm_sim_t* sim, bfm_instance_t* instance, bfm_system_t* system) {
+	instance->system = system;
+
+	system->ordering = sim->ordering;
+	system->sparse = sim->solver == BFM_SIM_SOLVER_SPARSE && system->symmetric;
+
+	// non-symmetric systems fall back to a band factorization, which needs a bandwidth-reducing ordering
+
+	if (sim->solver == BFM_SIM_SOLVER_SPARSE && !system->symmetric) {
+		system->ordering = BFM_PERM_KIND_RCM;
+	}
+
+	if (bfm_system_factorize(system) < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int factorize_elasticity_instance(bfm_sim_t* sim, bfm_instance_t* instance, system_create_elasticity_fn_t system_create_fn) {
+	bfm_state_t* const state = sim->state;
+
+	bfm_instance_release_system(instance);
+
+	bfm_system_t* const system = state->alloc(sizeof *system);
+
+	if (system == NULL) {
+		return -1;
+	}
+
+	bfm_system_layout_t layout;
+	system_layout(sim, false, &layout);
+
+	if (system_create_fn(system, instance, sim->n_forces, sim->forces, &layout) < 0) {
+		state->free(system);
+		return -1;
+	}
+
+	return attach_and_factorize(sim, instance, system);
+}
+
+static int run_elasticity_instance(bfm_sim_t* sim, bfm_instance_t* instance, system_create_elasticity_fn_t system_create_fn) {
+	bfm_state_t* const state = sim->state;
+
+	// any previously factorized system is now stale
+
+	bfm_instance_release_system(instance);
+
+	bfm_system_t* const system = state->alloc(sizeof *system);
+
+	if (system == NULL) {
+		return -1;
+	}
+
+	// create and solve elasticity system
+
+	bfm_system_layout_t layout;
+	system_layout(sim, true, &layout);
+
+	if (system_create_fn(system, instance, sim->n_forces, sim->forces, &layout) < 0) {
+		state->free(system);
+		return -1;
+	}
+
+	// iterative solver works on the sparse system as is
+	// it only applies to symmetric systems, others are always solved directly
+	// there is no factorization to keep around in that case
+
+	if (sim->solver == BFM_SIM_SOLVER_PCG && system->symmetric) {
+		int const rv = bfm_matrix_solve_pcg(&system->A, &system->b, &sim->pcg);
+
+		if (rv == 0) {
+			set_effects(instance, &system->b);
+		}
+
+		bfm_system_destroy(system);
+		state->free(system);
+
+		return rv;
+	}
+
+	if (attach_and_factorize(sim, instance, system) < 0) {
+		return -1;
+	}
+
+	if (bfm_system_solve(system, &system->b) < 0) {
+		return -1;
+	}
+
+	// set instance effects to result of equation
+
+	set_effects(instance, &system->b);
+
+	return 0;
+}
+
+static int resolve_elasticity_instance(bfm_sim_t* sim, bfm_instance_t* instance, system_create_elasticity_fn_t system_create_fn) {
+	bfm_system_t* const factorized = instance->system;
+
+	// nothing to reuse, so do a full run
+
+	if (factorized == NULL || !factorized->factorized) {
+		return run_elasticity_instance(sim, instance, system_create_fn);
+	}
+
+	// only the right-hand side depends on the new forces, Neumann values and Dirichlet lifting, so rebuild just that
+
+	if (bfm_system_assemble_loads(factorized, instance, sim->n_forces, sim->forces) < 0) {
+		return -1;
+	}
+
+	if (bfm_system_solve(factorized, &factorized->b) < 0) {
+		return -1;
+	}
+
+	set_effects(instance, &factorized->b);
+
+	return 0;
+}
 
 static int run_elasticity(bfm_sim_t* sim, system_create_elasticity_fn_t system_create_fn) {
 	for (size_t i = 0; i < sim->n_instances; i++) {
-		bfm_instance_t* const instance = sim->instances[i];
-		bfm_obj_t* const obj = instance->obj;
-		bfm_mesh_t* const mesh = obj->mesh;
-		size_t const dim = mesh->dim;
+		if (run_elasticity_instance(sim, sim->instances[i], system_create_fn) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int resolve_elasticity(bfm_sim_t* sim, system_create_elasticity_fn_t system_create_fn) {
+	for (size_t i = 0; i < sim->n_instances; i++) {
+		if (resolve_elasticity_instance(sim, sim->instances[i], system_create_fn) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// assemble the right-hand side of a load case into column c of an nxr row-major block
+
+static int load_case_rhs(bfm_sim_t* sim, bfm_instance_t* instance, bfm_load_case_t* load_case, bfm_vec_t* block, size_t c, size_t r) {
+	bfm_state_t* const state = sim->state;
+	int rv = -1;
+
+	// override condition values for the duration of the assembly
+
+	double* const old_values = state->alloc(load_case->n_conditions * sizeof *old_values);
+
+	if (load_case->n_conditions && old_values == NULL) {
+		goto err_old_values_alloc;
+	}
+
+	for (size_t i = 0; i < load_case->n_conditions; i++) {
+		old_values[i] = load_case->conditions[i]->value;
+		load_case->conditions[i]->value = load_case->values[i];
+	}
+
+	bfm_system_t* const system = instance->system;
+
+	if (bfm_system_assemble_loads(system, instance, load_case->n_forces, load_case->forces) < 0) {
+		goto err_assemble_loads;
+	}
+
+	for (size_t i = 0; i < system->n; i++) {
+		block->data[i * r + c] = system->b.data[i];
+	}
+
+	// success
+
+	rv = 0;
+
+err_assemble_loads:
+
+	// restore in reverse order, in case a condition appears more than once
+
+	for (ssize_t i = load_case->n_conditions - 1; i >= 0; i--) {
+		load_case->conditions[i]->value = old_values[i];
+	}
+
+	state->free(old_values);
+
+err_old_values_alloc:
+
+	return rv;
+}
+
+static int run_load_cases_instance(bfm_sim_t* sim, bfm_instance_t* instance, size_t n_cases, bfm_load_case_t* cases, system_create_elasticity_fn_t system_create_fn) {
+	bfm_state_t* const state = sim->state;
+
+	// load cases are always solved directly, with the factorized system of the last run if there is one
+
+	if (instance->system == NULL || !instance->system->factorized) {
+		if (factorize_elasticity_instance(sim, instance, system_create_fn) < 0) {
+			return -1;
+		}
+	}
+
+	bfm_system_t* const factorized = instance->system;
+	size_t const n = factorized->n;
+
+	// gather right-hand sides of all load cases & solve for them at once
+
+	bfm_vec_t __attribute__((cleanup(bfm_vec_destroy))) block;
+
+	if (bfm_vec_create(&block, state, n * n_cases) < 0) {
+		return -1;
+	}
+
+	for (size_t c = 0; c < n_cases; c++) {
+		if (load_case_rhs(sim, instance, &cases[c], &block, c, n_cases) < 0) {
+			return -1;
+		}
+	}
+
+	if (bfm_system_solve_multi(factorized, n_cases, &block) < 0) {
+		return -1;
+	}
+
+	// write out effects of each load case
+
+	double* const case_effects = state->realloc(instance->case_effects, n_cases * n * sizeof *case_effects);
+
+	if (case_effects == NULL) {
+		return -1;
+	}
 
-		// create and solve elasticity system
+	instance->n_cases = n_cases;
+	instance->case_effects = case_effects;
 
-		bfm_system_t __attribute__((cleanup(bfm_system_destroy))) system;
+	for (size_t c = 0; c < n_cases; c++) {
+		for (size_t i = 0; i < n; i++) {
+			case_effects[c * n + i] = block.data[i * n_cases + c];
+		}
+	}
 
-		if (system_create_fn(&system, instance, sim->n_forces, sim->forces) < 0) {
+	return 0;
+}
+
+static int run_load_cases(bfm_sim_t* sim, size_t n_cases, bfm_load_case_t* cases, system_create_elasticity_fn_t system_create_fn) {
+	for (size_t i = 0; i < sim->n_instances; i++) {
+		if (run_load_cases_instance(sim, sim->instances[i], n_cases, cases, system_create_fn) < 0) {
 			return -1;
 		}
+	}
+
+	return 0;
+}
+
+// material parameter sweeps
+// stiffness is linear in E, so a system factorized for E0 gives the solution for E by scaling its loads by E0 / E
+// nu enters the stiffness non-linearly, so only parameter sets with a different nu need a new factorization
+
+static int sweep_group(bfm_sim_t* sim, bfm_instance_t* instance, size_t n_params, bfm_sweep_params_t* params, bool* done, size_t first, double E0) {
+	bfm_state_t* const state = sim->state;
+	bfm_material_t* const material = instance->obj->material;
+	bfm_system_t* const system = instance->system;
+	size_t const n = system->n;
+	double const nu = params[first].nu;
+
+	// count parameter sets left sharing the nu of the first one
+
+	size_t r = 0;
+
+	for (size_t p = first; p < n_params; p++) {
+		r += !done[p] && params[p].nu == nu;
+	}
+
+	// gather right-hand sides of all of them & solve for them at once
+	// body forces scale with rho, which is set on the material for the assembly
+
+	bfm_vec_t __attribute__((cleanup(bfm_vec_destroy))) block;
+
+	if (bfm_vec_create(&block, state, n * r) < 0) {
+		return -1;
+	}
+
+	for (size_t p = first, c = 0; p < n_params; p++) {
+		if (done[p] || params[p].nu != nu) {
+			continue;
+		}
 
-		if (bfm_system_renumber(&system) < 0) {
+		material->rho = params[p].rho;
+
+		if (bfm_system_assemble_loads_scaled(system, instance, sim->n_forces, sim->forces, E0 / params[p].E) < 0) {
 			return -1;
 		}
 
-		bfm_matrix_solve(&system.A, &system.b);
-		bfm_perm_perm_vec(&system.perm, &system.b, true);
+		for (size_t i = 0; i < n; i++) {
+			block.data[i * r + c] = system->b.data[i];
+		}
+
+		c++;
+	}
+
+	if (bfm_system_solve_multi(system, r, &block) < 0) {
+		return -1;
+	}
+
+	// write out effects of each parameter set
+
+	for (size_t p = first, c = 0; p < n_params; p++) {
+		if (done[p] || params[p].nu != nu) {
+			continue;
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			instance->sweep_effects[p * n + i] = block.data[i * r + c];
+		}
+
+		done[p] = true;
+		c++;
+	}
+
+	return 0;
+}
+
+static int run_sweep_instance(bfm_sim_t* sim, bfm_instance_t* instance, size_t n_params, bfm_sweep_params_t* params, system_create_elasticity_fn_t system_create_fn) {
+	bfm_state_t* const state = sim->state;
+	bfm_material_t* const material = instance->obj->material;
+	int rv = -1;
+
+	double* const sweep_effects = state->realloc(instance->sweep_effects, n_params * instance->n_effects * sizeof *sweep_effects);
+
+	if (sweep_effects == NULL) {
+		goto err_sweep_effects_alloc;
+	}
+
+	instance->n_sweeps = n_params;
+	instance->sweep_effects = sweep_effects;
+
+	bool* const done = state->alloc(n_params * sizeof *done);
+
+	if (done == NULL) {
+		goto err_done_alloc;
+	}
+
+	memset(done, 0, n_params * sizeof *done);
+
+	// the material is modified for the duration of the sweep
+	// once it has been, the factorized system of the instance is no longer valid for the original one
+
+	double const E = material->E;
+	double const nu = material->nu;
+	double const rho = material->rho;
+
+	bool stale = false;
+
+	for (size_t p = 0; p < n_params; p++) {
+		if (done[p]) {
+			continue;
+		}
+
+		// reuse the factorization of the last run if it was for the same nu, refactorize for this parameter set otherwise
 
-		// set instance effects to result of equation
+		double E0 = params[p].E;
 
-		for (size_t j = 0; j < mesh->n_nodes; j++) {
-			for (size_t k = 0; k < dim; k++) {
-				instance->effects[j * dim + k] = system.b.data[j * dim + k];
+		if (!stale && params[p].nu == nu && instance->system != NULL && instance->system->factorized) {
+			E0 = E;
+		}
+
+		else {
+			material->E = params[p].E;
+			material->nu = params[p].nu;
+			material->rho = params[p].rho;
+
+			stale = true;
+
+			if (factorize_elasticity_instance(sim, instance, system_create_fn) < 0) {
+				goto err_solve;
 			}
 		}
+
+		if (sweep_group(sim, instance, n_params, params, done, p, E0) < 0) {
+			goto err_solve;
+		}
+	}
+
+	// success
+
+	rv = 0;
+
+err_solve:
+
+	material->E = E;
+	material->nu = nu;
+	material->rho = rho;
+
+	if (stale) {
+		bfm_instance_release_system(instance);
+	}
+
+	state->free(done);
+
+err_done_alloc:
+err_sweep_effects_alloc:
+
+	return rv;
+}
+
+static int run_sweep(bfm_sim_t* sim, size_t n_params, bfm_sweep_params_t* params, system_create_elasticity_fn_t system_create_fn) {
+	for (size_t i = 0; i < sim->n_instances; i++) {
+		if (run_sweep_instance(sim, sim->instances[i], n_params, params, system_create_fn) < 0) {
+			return -1;
+		}
 	}
 
 	return 0;
 }
 
+static system_create_elasticity_fn_t elasticity_fn(bfm_sim_kind_t kind) {
+	if (kind == BFM_SIM_KIND_PLANAR_STRAIN) {
+		return bfm_system_create_planar_strain;
+	}
+
+	if (kind == BFM_SIM_KIND_PLANAR_STRESS) {
+		return bfm_system_create_planar_stress;
+	}
+
+	if (kind == BFM_SIM_KIND_AXISYMMETRIC_STRAIN) {
+		return bfm_system_create_axisymmetric_strain;
+	}
+
+	return NULL;
+}
+
 int bfm_sim_run(bfm_sim_t* sim) {
 	if (sim->kind == BFM_SIM_KIND_NONE) {
 		return 0;
 	}
 
-	if (sim->kind == BFM_SIM_KIND_PLANAR_STRAIN) {
-		return run_elasticity(sim, bfm_system_create_planar_strain);
+	system_create_elasticity_fn_t const fn = elasticity_fn(sim->kind);
+
+	if (fn == NULL) {
+		return -1;
+	}
+
+	return run_elasticity(sim, fn);
+}
+
+int bfm_sim_resolve(bfm_sim_t* sim) {
+	if (sim->kind == BFM_SIM_KIND_NONE) {
+		return 0;
+	}
+
+	system_create_elasticity_fn_t const fn = elasticity_fn(sim->kind);
+
+	if (fn == NULL) {
+		return -1;
+	}
+
+	return resolve_elasticity(sim, fn);
+}
+
+int bfm_sim_run_load_cases(bfm_sim_t* sim, size_t n_cases, bfm_load_case_t* cases) {
+	if (sim->kind == BFM_SIM_KIND_NONE || !n_cases) {
+		return 0;
+	}
+
+	system_create_elasticity_fn_t const fn = elasticity_fn(sim->kind);
+
+	if (fn == NULL) {
+		return -1;
 	}
 
-	if (sim->kind == BFM_SIM_KIND_PLANAR_STRESS) {
-		return run_elasticity(sim, bfm_system_create_planar_stress);
+	return run_load_cases(sim, n_cases, cases, fn);
+}
+
+int bfm_sim_run_sweep(bfm_sim_t* sim, size_t n_params, bfm_sweep_params_t* params) {
+	if (sim->kind == BFM_SIM_KIND_NONE || !n_params) {
+		return 0;
+	}
+
+	system_create_elasticity_fn_t const fn = elasticity_fn(sim->kind);
+
+	if (fn == NULL) {
+		return -1;
 	}
 
-	if (sim->kind == BFM_SIM_KIND_AXISYMMETRIC_STRAIN) {
-		return run_elasticity(sim, bfm_system_create_axisymmetric_strain);
+	// loads are scaled by the inverse of Young's modulus
+
+	for (size_t p = 0; p < n_params; p++) {
+		if (params[p].E <= 0) {
+			return -1;
+		}
 	}
 
-	return -1;
+	return run_sweep(sim, n_params, params, fn);
 }
@@ -10,6 +10,8 @@ int bfm_state_create(bfm_state_t* state) {
 	state->realloc = realloc;
 	state->free = free;
 
+	state->n_threads = 1;
+
 	return 0;
 }
 
@@ -33,6 +35,15 @@ int bfm_set_free(bfm_state_t* state, bfm_free_t free) {
 	return 0;
 }
 
+int bfm_set_n_threads(bfm_state_t* state, size_t n_threads) {
+	if (!n_threads) {
+		return -1;
+	}
+
+	state->n_threads = n_threads;
+	return 0;
+}
+
 int bfm_err_print(bfm_state_t* state) {
 	bfm_err_t* const err = &state->err;
 
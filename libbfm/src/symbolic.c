@@ -0,0 +1,165 @@
+#include <string.h>
+
+#include <bfm/symbolic.h>
+
+// compute where the local matrix of each element lands in the data of a matrix with the sparsity pattern of the analysis
+
+static int create_scatter(bfm_symbolic_t* symbolic, bfm_mesh_t* mesh) {
+	bfm_state_t* const state = symbolic->state;
+	size_t const dim = symbolic->dim;
+	size_t const n = symbolic->elem_dofs;
+
+	symbolic->scatter = state->alloc(mesh->n_elems * n * n * sizeof *symbolic->scatter);
+
+	if (symbolic->scatter == NULL) {
+		return -1;
+	}
+
+	// matrix sharing the pattern, only used to look up offsets in it
+
+	bfm_matrix_t pattern;
+
+	if (bfm_matrix_csr_create_shared(&pattern, state, symbolic->n, symbolic->offsets, symbolic->cols) < 0) {
+		return -1;
+	}
+
+	size_t dofs[n];
+
+	for (size_t i = 0; i < mesh->n_elems; i++) {
+		size_t const* const elem = &mesh->elems[i * mesh->kind];
+
+		for (size_t j = 0; j < (size_t) mesh->kind; j++) {
+			for (size_t p = 0; p < dim; p++) {
+				dofs[dim * j + p] = dim * elem[j] + p;
+			}
+		}
+
+		if (bfm_matrix_block_offsets(&pattern, n, dofs, &symbolic->scatter[i * n * n]) < 0) {
+			bfm_matrix_destroy(&pattern);
+			return -1;
+		}
+	}
+
+	bfm_matrix_destroy(&pattern);
+	return 0;
+}
+
+int bfm_symbolic_create(bfm_symbolic_t* symbolic, bfm_state_t* state, bfm_mesh_t* mesh) {
+	memset(symbolic, 0, sizeof *symbolic);
+	symbolic->state = state;
+
+	symbolic->dim = mesh->dim;
+	symbolic->n = mesh->n_nodes * mesh->dim;
+	symbolic->elem_dofs = mesh->dim * mesh->kind;
+
+	if (bfm_perm_create(&symbolic->node_perm, state, mesh->n_nodes) < 0) {
+		goto err_perm;
+	}
+
+	// each node's DOFs are coupled to all the DOFs of all the nodes it shares an element with
+
+	if (bfm_graph_create_mesh(&symbolic->graph, state, mesh) < 0) {
+		goto err_graph;
+	}
+
+	bfm_graph_t dof_graph;
+
+	if (bfm_graph_create_expand(&dof_graph, &symbolic->graph, mesh->dim) < 0) {
+		goto err_dof_graph;
+	}
+
+	// the DOF graph is the sparsity pattern, so just take over its arrays
+
+	symbolic->nnz = dof_graph.offsets[symbolic->n];
+	symbolic->offsets = dof_graph.offsets;
+	symbolic->cols = dof_graph.neighbours;
+
+	if (create_scatter(symbolic, mesh) < 0) {
+		goto err_scatter;
+	}
+
+	return 0;
+
+err_scatter:
+
+	state->free(symbolic->scatter);
+	bfm_graph_destroy(&dof_graph);
+
+err_dof_graph:
+
+	bfm_graph_destroy(&symbolic->graph);
+
+err_graph:
+
+	bfm_perm_destroy(&symbolic->node_perm);
+
+err_perm:
+
+	return -1;
+}
+
+int bfm_symbolic_destroy(bfm_symbolic_t* symbolic) {
+	bfm_state_t* const state = symbolic->state;
+
+	bfm_graph_destroy(&symbolic->graph);
+	bfm_perm_destroy(&symbolic->node_perm);
+
+	state->free(symbolic->offsets);
+	state->free(symbolic->cols);
+	state->free(symbolic->scatter);
+
+	return 0;
+}
+
+bfm_symbolic_t* bfm_symbolic_get(bfm_mesh_t* mesh) {
+	bfm_state_t* const state = mesh->state;
+
+	if (mesh->symbolic != NULL) {
+		return mesh->symbolic;
+	}
+
+	bfm_symbolic_t* const symbolic = state->alloc(sizeof *symbolic);
+
+	if (symbolic == NULL) {
+		return NULL;
+	}
+
+	if (bfm_symbolic_create(symbolic, state, mesh) < 0) {
+		state->free(symbolic);
+		return NULL;
+	}
+
+	mesh->symbolic = symbolic;
+	return symbolic;
+}
+
+int bfm_symbolic_release(bfm_mesh_t* mesh) {
+	bfm_state_t* const state = mesh->state;
+
+	if (mesh->symbolic == NULL) {
+		return 0;
+	}
+
+	bfm_symbolic_destroy(mesh->symbolic);
+	state->free(mesh->symbolic);
+	mesh->symbolic = NULL;
+
+	return 0;
+}
+
+int bfm_symbolic_order(bfm_symbolic_t* symbolic, bfm_perm_kind_t kind) {
+	if (symbolic->has_ordering && symbolic->ordering == kind) {
+		return 0;
+	}
+
+	symbolic->has_ordering = false;
+
+	if (bfm_perm_order(&symbolic->node_perm, &symbolic->graph, kind) < 0) {
+		return -1;
+	}
+
+	symbolic->has_ordering = true;
+	symbolic->ordering = kind;
+
+	return 0;
+}
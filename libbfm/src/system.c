@@ -1,16 +1,45 @@
+#include <pthread.h>
+#include <stdint.h>
 #include <string.h>
 
+#include <bfm/graph.h>
 #include <bfm/system.h>
+#include <bfm/team.h>
+
+int bfm_system_create(bfm_system_t* system, bfm_state_t* state, bfm_mesh_t* mesh) {
+	size_t const n = mesh->n_nodes * mesh->dim;
 
-int bfm_system_create(bfm_system_t* system, bfm_state_t* state, size_t n) {
 	system->state = state;
 	system->n = n;
+	system->dim = mesh->dim;
+	system->symmetric = false;
+	system->factorized = false;
+	system->renumbered = false;
+	system->ordering = BFM_PERM_KIND_RCM;
+	system->sparse = false;
+	system->axisymmetric = false;
+
+	system->n_conditions = 0;
+	system->n_lifts = 0;
+	system->lift_slots = NULL;
+	system->lifts = NULL;
+	system->constrained = NULL;
+	system->scales = NULL;
+
+	// the sparsity pattern of the system matrix only depends on the connectivity of the mesh
+	// it is thus analysed once per mesh and shared by all the systems created over it
+
+	system->symbolic = bfm_symbolic_get(mesh);
+
+	if (system->symbolic == NULL) {
+		goto err_symbolic;
+	}
 
 	if (bfm_perm_create(&system->perm, state, n) < 0) {
 		goto err_perm;
 	}
 
-	if (bfm_matrix_full_create(&system->A, state, BFM_MATRIX_MAJOR_ROW, n) < 0) {
+	if (bfm_matrix_csr_create_shared(&system->A, state, n, system->symbolic->offsets, system->symbolic->cols) < 0) {
 		goto err_matrix;
 	}
 
@@ -29,47 +58,91 @@ err_matrix:
 	bfm_perm_destroy(&system->perm);
 
 err_perm:
+err_symbolic:
 
 	return -1;
 }
 
 int bfm_system_destroy(bfm_system_t* system) {
+	if (system->sparse && system->factorized) {
+		bfm_chol_destroy(&system->chol);
+	}
+
 	bfm_perm_destroy(&system->perm);
 	bfm_matrix_destroy(&system->A);
 	bfm_vec_destroy(&system->b);
 
+	if (system->lift_slots != NULL) {
+		system->state->free(system->lift_slots);
+	}
+
+	if (system->lifts != NULL) {
+		system->state->free(system->lifts);
+	}
+
+	if (system->constrained != NULL) {
+		system->state->free(system->constrained);
+	}
+
+	if (system->scales != NULL) {
+		system->state->free(system->scales);
+	}
+
 	return 0;
 }
 
-int bfm_system_renumber(bfm_system_t* system) {
-	bfm_state_t* const state = system->state;
+// create permutation vector
+// this is done on the nodes of the mesh rather than on the DOFs, as the graph is dim^2 times smaller, and then expanded to the DOFs
+// node orderings are cached on the symbolic analysis of the mesh, so they're only computed once for all the systems created over it
+// the system matrix itself is never permuted, only read through the permutation
 
-	// create RCM permutation vector
+static int create_perm(bfm_system_t* system) {
+	bfm_symbolic_t* const symbolic = system->symbolic;
 
-	if (bfm_perm_rcm(&system->perm, &system->A) < 0) {
+	if (bfm_symbolic_order(symbolic, system->ordering) < 0) {
 		return -1;
 	}
 
-	// apply permutation to system matrix and vector
-
-	if (bfm_perm_perm_matrix(&system->perm, &system->A, false) < 0) {
+	if (bfm_perm_expand(&system->perm, &symbolic->node_perm, system->dim) < 0) {
 		return -1;
 	}
 
-	if (bfm_perm_perm_vec(&system->perm, &system->b, false) < 0) {
-		return -1;
+	return 0;
+}
+
+// create the band matrix the system matrix is renumbered into
+// symmetric systems only need the upper half-band
+// the bandwidth of the renumbered matrix is known from the ordering already, so it never has to be measured on a matrix
+
+static int create_band(bfm_system_t* system, bfm_matrix_t* A) {
+	size_t const bandwidth = system->perm.bandwidth;
+
+	if (system->symmetric) {
+		return bfm_matrix_sym_band_create(A, system->state, system->n, bandwidth);
 	}
 
-	// turn full matrix into band matrix
+	return bfm_matrix_band_create(A, system->state, system->n, bandwidth);
+}
+
+// renumber system matrix and turn it into a band matrix
+// the sparse matrix is scattered straight into the band matrix with the permutation applied, so no intermediate permuted copy is needed
+
+static int renumber_matrix(bfm_system_t* system) {
+	if (system->renumbered) {
+		return 0;
+	}
+
+	if (create_perm(system) < 0) {
+		return -1;
+	}
 
-	size_t const bandwidth = bfm_matrix_bandwidth(&system->A);
 	bfm_matrix_t A;
 
-	if (bfm_matrix_band_create(&A, state, system->A.major, system->A.m, bandwidth) < 0) {
+	if (create_band(system, &A) < 0) {
 		return -1;
 	}
 
-	if (bfm_matrix_copy(&A, &system->A) < 0) {
+	if (bfm_perm_copy_matrix(&system->perm, &A, &system->A, false) < 0) {
 		bfm_matrix_destroy(&A);
 		return -1;
 	}
@@ -77,6 +150,131 @@ int bfm_system_renumber(bfm_system_t* system) {
 	bfm_matrix_destroy(&system->A);
 	memcpy(&system->A, &A, sizeof A);
 
+	system->renumbered = true;
+	return 0;
+}
+
+int bfm_system_renumber(bfm_system_t* system, bfm_perm_kind_t ordering) {
+	// a system which is renumbered already can't be renumbered with another ordering
+
+	if (system->renumbered && ordering != system->ordering) {
+		return -1;
+	}
+
+	system->ordering = ordering;
+
+	if (renumber_matrix(system) < 0) {
+		return -1;
+	}
+
+	// apply permutation to system vector too
+
+	if (bfm_perm_perm_vec(&system->perm, &system->b, false) < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+// keep the matrix sparse and compute the sparse Cholesky factorization of its renumbered version
+
+static int factorize_sparse(bfm_system_t* system) {
+	if (!system->symmetric || system->renumbered) {
+		return -1;
+	}
+
+	if (create_perm(system) < 0) {
+		return -1;
+	}
+
+	if (bfm_chol_create(&system->chol, system->state, &system->A, &system->perm) < 0) {
+		return -1;
+	}
+
+	if (bfm_chol_factorize(&system->chol, &system->A, &system->perm) < 0) {
+		bfm_chol_destroy(&system->chol);
+		return -1;
+	}
+
+	return 0;
+}
+
+int bfm_system_factorize(bfm_system_t* system) {
+	if (system->factorized) {
+		return 0;
+	}
+
+	if (system->sparse) {
+		if (factorize_sparse(system) < 0) {
+			return -1;
+		}
+	}
+
+	else {
+		if (renumber_matrix(system) < 0) {
+			return -1;
+		}
+
+		if (bfm_matrix_lu(&system->A) < 0) {
+			return -1;
+		}
+	}
+
+	system->factorized = true;
+	return 0;
+}
+
+int bfm_system_solve(bfm_system_t* system, bfm_vec_t* vec) {
+	if (!system->factorized) {
+		return -1;
+	}
+
+	if (bfm_perm_perm_vec(&system->perm, vec, false) < 0) {
+		return -1;
+	}
+
+	int const rv = system->sparse ?
+		bfm_chol_solve(&system->chol, vec) :
+		bfm_matrix_lu_solve(&system->A, vec);
+
+	if (rv < 0) {
+		return -1;
+	}
+
+	if (bfm_perm_perm_vec(&system->perm, vec, true) < 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+int bfm_system_solve_multi(bfm_system_t* system, size_t r, bfm_vec_t* vec) {
+	if (!system->factorized) {
+		return -1;
+	}
+
+	if (vec->n != system->n * r) {
+		return -1;
+	}
+
+	// permute rows of the block of right-hand sides in place
+
+	if (bfm_perm_perm_rows(&system->perm, vec, r, false) < 0) {
+		return -1;
+	}
+
+	int const rv = system->sparse ?
+		bfm_chol_solve_multi(&system->chol, r, vec) :
+		bfm_matrix_lu_solve_multi(&system->A, r, vec);
+
+	if (rv < 0) {
+		return -1;
+	}
+
+	if (bfm_perm_perm_rows(&system->perm, vec, r, true) < 0) {
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -90,6 +288,11 @@ typedef struct {
 	double coord[2][4];
 } elem_t;
 
+// local element matrices & load vectors have one row/column per DOF of each of the element's nodes
+// the DOFs of node j of the element are rows/columns dim * j to dim * j + dim - 1
+
+#define ELEM_DOFS (2 * 4)
+
 static void get_elem(elem_t* elem, bfm_mesh_t* mesh, size_t i) {
 	bfm_elem_kind_t const kind = mesh->kind;
 	size_t const dim = mesh->dim;
@@ -106,30 +309,30 @@ static void get_elem(elem_t* elem, bfm_mesh_t* mesh, size_t i) {
 	}
 }
 
-static int fill_elasticity_elem(elem_t* elem, bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, double const a, double const b, double const c) {
-	bfm_state_t* const state = instance->state;
-	bfm_obj_t* const obj = instance->obj;
-	bfm_material_t* const material = obj->material;
-	bfm_rule_t* const rule = obj->rule;
-	bfm_shape_t* const shape = &rule->shape;
-	size_t dim = rule->dim;
-
-	bfm_matrix_t* const stiffness_mat = &system->A;
-	bfm_vec_t* const forces_vec = &system->b;
+// add the contribution of body forces at an integration point to the load vector of a planar element
+// scale is the jacobian determinant times the weight of the integration point
+// node_forces is the sum of all body forces at each node of the mesh (see eval_node_forces), NULL if there are none
 
-	// vectors to be used later
+static void add_elem_load(elem_t* elem, double* fe, double const* phi, double scale, double rho, double const* node_forces) {
+	if (node_forces == NULL) {
+		return;
+	}
 
-	bfm_vec_t __attribute__((cleanup(bfm_vec_destroy))) pos;
+	for (size_t j = 0; j < elem->kind; j++) {
+		double const* const applied_force = &node_forces[elem->map[j] * 2];
 
-	if (bfm_vec_create(&pos, state, dim) < 0) {
-		return -1;
+		fe[2 * j + 0] += scale * applied_force[0] * rho * phi[j];
+		fe[2 * j + 1] += scale * applied_force[1] * rho * phi[j];
 	}
+}
 
-	bfm_vec_t __attribute__((cleanup(bfm_vec_destroy))) applied_force;
+static int fill_elasticity_elem(elem_t* elem, double* ke, double* fe, bfm_instance_t* instance, double const* node_forces, double const a, double const b, double const c) {
+	bfm_obj_t* const obj = instance->obj;
+	bfm_material_t* const material = obj->material;
+	bfm_rule_t* const rule = obj->rule;
+	size_t dim = rule->dim;
 
-	if (bfm_vec_create(&applied_force, state, dim) < 0) {
-		return -1;
-	}
+	size_t const n = dim * elem->kind;
 
 	// go through integration points
 
@@ -137,7 +340,6 @@ static int fill_elasticity_elem(elem_t* elem, bfm_system_t* system, bfm_instance
 		// element variables
 
 		bfm_elem_kind_t const kind = elem->kind;
-		size_t* const map = elem->map;
 
 		double* const x = elem->coord[0];
 		double* const y = elem->coord[1];
@@ -146,16 +348,11 @@ static int fill_elasticity_elem(elem_t* elem, bfm_system_t* system, bfm_instance
 
 		double const weight = rule->weights[i];
 
-		// shape function & its derivatives wrt xsi & eta
+		// shape function & its derivatives wrt xsi & eta, as tabulated on the rule
 
-		double phi[4];
-		shape->phi(shape, rule->points[i], phi);
-
-		double dphi_dxsi[4];
-		double dphi_deta[4];
-
-		shape->dphi(shape, 0, rule->points[i], dphi_dxsi);
-		shape->dphi(shape, 1, rule->points[i], dphi_deta);
+		double const* const phi = &rule->phi[i * kind];
+		double const* const dphi_dxsi = &rule->dphi_dxsi[i * kind];
+		double const* const dphi_deta = &rule->dphi_deta[i * kind];
 
 		// compute jacobian and its determinant
 		// TODO when determinant is negative, our vertices are incorrectly ordered
@@ -187,38 +384,30 @@ static int fill_elasticity_elem(elem_t* elem, bfm_system_t* system, bfm_instance
 
 		// populate force vector
 
-		for (size_t j = 0; j < kind; j++) {
-			size_t const index_i = dim * map[j];
-
-			pos.data[0] = x[j];
-			pos.data[1] = y[j];
+		add_elem_load(elem, fe, phi, det_J * weight, material->rho, node_forces);
 
-			for (size_t k = 0; k < n_forces; k++) {
-				bfm_force_t* const force = forces[k];
-				bfm_force_eval(force, &pos, &applied_force);
+		// populate stiffness matrix, unless only loads are asked for
 
-				forces_vec->data[index_i + 0] += det_J * weight * applied_force.data[0] * material->rho * phi[j];
-				forces_vec->data[index_i + 1] += det_J * weight * applied_force.data[1] * material->rho * phi[j];
-			}
+		if (ke == NULL) {
+			continue;
 		}
 
-		// populate stiffness matrix
-
 		for (size_t j = 0; j < kind; j++) {
-			int const index_i = dim * map[j];
+			double* const row_0 = &ke[(dim * j + 0) * n];
+			double* const row_1 = &ke[(dim * j + 1) * n];
 
 			for (size_t k = 0; k < kind; k++) {
-				int const index_j = dim * map[k];
+				size_t const col = dim * k;
 
 				double const f_11 = a * dphi_dx[j] * dphi_dx[k] + c * dphi_dy[j] * dphi_dy[k];
 				double const f_12 = b * dphi_dx[j] * dphi_dy[k] + c * dphi_dy[j] * dphi_dx[k];
 				double const f_21 = b * dphi_dy[j] * dphi_dx[k] + c * dphi_dx[j] * dphi_dy[k];
 				double const f_22 = a * dphi_dy[j] * dphi_dy[k] + c * dphi_dx[j] * dphi_dx[k];
 
-				bfm_matrix_add(stiffness_mat, index_i + 0, index_j + 0, det_J * weight * f_11);
-				bfm_matrix_add(stiffness_mat, index_i + 0, index_j + 1, det_J * weight * f_12);
-				bfm_matrix_add(stiffness_mat, index_i + 1, index_j + 0, det_J * weight * f_21);
-				bfm_matrix_add(stiffness_mat, index_i + 1, index_j + 1, det_J * weight * f_22);
+				row_0[col + 0] += det_J * weight * f_11;
+				row_0[col + 1] += det_J * weight * f_12;
+				row_1[col + 0] += det_J * weight * f_21;
+				row_1[col + 1] += det_J * weight * f_22;
 			}
 		}
 	}
@@ -226,16 +415,13 @@ static int fill_elasticity_elem(elem_t* elem, bfm_system_t* system, bfm_instance
 	return 0;
 }
 
-static int fill_axisymmetric_elem(elem_t* elem, bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces) {
-	bfm_state_t* const state = instance->state;
+static int fill_axisymmetric_elem(elem_t* elem, double* ke, double* fe, bfm_instance_t* instance, double const* node_forces) {
 	bfm_obj_t* const obj = instance->obj;
 	bfm_material_t* const material = obj->material;
 	bfm_rule_t* const rule = obj->rule;
-	bfm_shape_t* const shape = &rule->shape;
 	size_t const dim = rule->dim;
 
-	bfm_matrix_t* const stiffness_mat = &system->A;
-	bfm_vec_t* const forces_vec = &system->b;
+	size_t const n = dim * elem->kind;
 
 	// constants
 
@@ -243,27 +429,12 @@ static int fill_axisymmetric_elem(elem_t* elem, bfm_system_t* system, bfm_instan
 	double const b = material->E * material->nu / (1 + material->nu) / (1 - 2 * material->nu);
 	double const c = material->E / (2 * (1 + material->nu));
 
-	// vectors to be used later
-
-	bfm_vec_t __attribute__((cleanup(bfm_vec_destroy))) pos;
-
-	if (bfm_vec_create(&pos, state, dim) < 0) {
-		return -1;
-	}
-
-	bfm_vec_t __attribute__((cleanup(bfm_vec_destroy))) applied_force;
-
-	if (bfm_vec_create(&applied_force, state, dim) < 0) {
-		return -1;
-	}
-
 	// go through integration points
 
 	for (size_t i = 0; i < rule->n_points; i++) {
 		// element variables
 
 		bfm_elem_kind_t const kind = elem->kind;
-		size_t* const map = elem->map;
 
 		double* const x = elem->coord[0];
 		double* const y = elem->coord[1];
@@ -272,16 +443,11 @@ static int fill_axisymmetric_elem(elem_t* elem, bfm_system_t* system, bfm_instan
 
 		double const weight = rule->weights[i];
 
-		// shape function & its derivatives wrt xsi & eta
-
-		double phi[4];
-		shape->phi(shape, rule->points[i], phi);
+		// shape function & its derivatives wrt xsi & eta, as tabulated on the rule
 
-		double dphi_dxsi[4];
-		double dphi_deta[4];
-
-		shape->dphi(shape, 0, rule->points[i], dphi_dxsi);
-		shape->dphi(shape, 1, rule->points[i], dphi_deta);
+		double const* const phi = &rule->phi[i * kind];
+		double const* const dphi_dxsi = &rule->dphi_dxsi[i * kind];
+		double const* const dphi_deta = &rule->dphi_deta[i * kind];
 
 		// compute jacobian and its determinant
 		// TODO when determinant is negative, our vertices are incorrectly ordered
@@ -316,64 +482,427 @@ static int fill_axisymmetric_elem(elem_t* elem, bfm_system_t* system, bfm_instan
 
 		// populate force vector
 
-		for (size_t j = 0; j < kind; j++) {
-			size_t const index_i = dim * map[j];
+		for (size_t j = 0; j < kind && node_forces != NULL; j++) {
+			double const* const applied_force = &node_forces[elem->map[j] * dim];
 
-			pos.data[0] = x[j];
-			pos.data[1] = y[j];
+			fe[dim * j + 0] += det_J * weight * applied_force[0] * material->rho * phi[j] * r;
+			fe[dim * j + 1] += det_J * weight * applied_force[1] * material->rho * phi[j] * r;
+		}
 
-			for (size_t k = 0; k < n_forces; k++) {
-				bfm_force_t* const force = forces[k];
-				bfm_force_eval(force, &pos, &applied_force);
+		// populate stiffness matrix, unless only loads are asked for
 
-				forces_vec->data[index_i + 0] += det_J * weight * applied_force.data[0] * material->rho * phi[j] * r;
-				forces_vec->data[index_i + 1] += det_J * weight * applied_force.data[1] * material->rho * phi[j] * r;
-			}
+		if (ke == NULL) {
+			continue;
 		}
 
-		// populate stiffness matrix
-
 		for (size_t j = 0; j < kind; j++) {
-			int const index_i = dim * map[j];
+			double* const row_0 = &ke[(dim * j + 0) * n];
+			double* const row_1 = &ke[(dim * j + 1) * n];
 
 			for (size_t k = 0; k < kind; k++) {
-				int const index_j = dim * map[k];
+				size_t const col = dim * k;
 
 				double const f_11 = a * dphi_dx[j] * dphi_dx[k] * r + c * dphi_dy[j] * dphi_dy[k] * r + phi[j] * (b * dphi_dx[k] + a * phi[k] / r) + dphi_dx[j] * b * phi[k];
 				double const f_12 = b * dphi_dx[j] * dphi_dy[k] * r + c * dphi_dy[j] * dphi_dx[k] * r + phi[j] * b * dphi_dy[k];
 				double const f_21 = b * dphi_dy[j] * dphi_dx[k] * r + c * dphi_dx[j] * dphi_dy[k] * r + dphi_dy[j] * b * phi[k];
 				double const f_22 = a * dphi_dy[j] * dphi_dy[k] * r + c * dphi_dx[j] * dphi_dx[k];
 
-				bfm_matrix_add(stiffness_mat, index_i + 0, index_j + 0, det_J * weight * f_11);
-				bfm_matrix_add(stiffness_mat, index_i + 0, index_j + 1, det_J * weight * f_12);
-				bfm_matrix_add(stiffness_mat, index_i + 1, index_j + 0, det_J * weight * f_21);
-				bfm_matrix_add(stiffness_mat, index_i + 1, index_j + 1, det_J * weight * f_22);
+				row_0[col + 0] += det_J * weight * f_11;
+				row_0[col + 1] += det_J * weight * f_12;
+				row_1[col + 0] += det_J * weight * f_21;
+				row_1[col + 1] += det_J * weight * f_22;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// parallel assembly
+// elements are assembled color by color, each color being split evenly between the threads of a team (see bfm/team.h), with a barrier in between colors
+// since no two elements of a color share a node, threads never write to the same entries
+// this also means every entry receives its contributions in the same order whatever the thread count, so results are bitwise identical
+
+typedef struct {
+	bfm_system_t* system;
+	bfm_instance_t* instance;
+	bfm_mesh_t* mesh;
+
+	size_t n_forces;
+	bfm_force_t** forces;
+	double* node_forces; // sum of the body forces at each node, evaluated once before going through the elements
+
+	bool axisymmetric;
+	bool loads_only; // only fill in b, leaving A untouched
+	size_t batch;    // number of elements filled at once, more than 1 if the batched kernel is used
+
+	double a;
+	double b;
+	double c;
+} assembly_t;
+
+// eliminate the DOFs constrained by Dirichlet conditions from the local matrix of an element before it's scattered
+// the columns of constrained DOFs are moved over to the lifting of the conditions constraining them (see build_constraints), and their rows are dropped
+// this leaves the rows & columns of constrained DOFs empty in A, save for the diagonal which is set once assembly is done
+// since the lifting of a DOF only receives contributions from elements the DOF is part of, this is as safe to do concurrently as the scatter itself
+
+static void eliminate_constrained(bfm_system_t* system, elem_t* elem, double* ke) {
+	size_t const dim = system->dim;
+	size_t const n = dim * elem->kind;
+
+	size_t dofs[ELEM_DOFS];
+	bool any = false;
+
+	for (size_t j = 0; j < elem->kind; j++) {
+		for (size_t p = 0; p < dim; p++) {
+			size_t const dof = dim * elem->map[j] + p;
+
+			dofs[dim * j + p] = dof;
+			any |= system->constrained[dof] != 0;
+		}
+	}
+
+	if (!any) {
+		return;
+	}
+
+	for (size_t q = 0; q < n; q++) {
+		size_t const cond = system->constrained[dofs[q]];
+
+		if (!cond) {
+			continue;
+		}
+
+		double* const lift = &system->lifts[system->lift_slots[cond - 1] * system->n];
+		double const scale = system->scales[dofs[q]];
+
+		for (size_t p = 0; p < n; p++) {
+			if (!system->constrained[dofs[p]]) {
+				lift[dofs[p]] -= scale * ke[p * n + q];
+			}
+
+			ke[p * n + q] = 0;
+			ke[q * n + p] = 0;
+		}
+	}
+}
+
+// scatter the local matrix & load vector of an element into the system in one go, at the offsets found by the symbolic analysis
+
+// DOFs constrained by Dirichlet conditions are eliminated on the fly (see eliminate_constrained)
+// if A is a band matrix assembled in the renumbered order, the offsets are cheap enough to compute per element instead
+
+static int scatter_elem(bfm_system_t* system, elem_t* elem, size_t i, double* ke, double const* fe) {
+	size_t const dim = system->dim;
+	size_t const n = dim * elem->kind;
+
+	if (ke != NULL) {
+		eliminate_constrained(system, elem, ke);
+
+		size_t const* offsets = &system->symbolic->scatter[i * n * n];
+		size_t band_offsets[ELEM_DOFS * ELEM_DOFS];
+
+		if (system->renumbered) {
+			size_t dofs[ELEM_DOFS];
+
+			for (size_t j = 0; j < elem->kind; j++) {
+				for (size_t p = 0; p < dim; p++) {
+					dofs[dim * j + p] = system->perm.perm[dim * elem->map[j] + p];
+				}
+			}
+
+			if (bfm_matrix_block_offsets(&system->A, n, dofs, band_offsets) < 0) {
+				return -1;
 			}
+
+			offsets = band_offsets;
+		}
+
+		if (bfm_matrix_add_block(&system->A, n, offsets, ke) < 0) {
+			return -1;
+		}
+	}
+
+	for (size_t j = 0; j < elem->kind; j++) {
+		for (size_t p = 0; p < dim; p++) {
+			system->b.data[dim * elem->map[j] + p] += fe[dim * j + p];
 		}
 	}
 
 	return 0;
 }
 
-static void apply_constraint(bfm_system_t* system, size_t node, double value) {
-	// TODO deal with band matrices
+static int fill_elem(assembly_t* assembly, size_t i) {
+	bfm_system_t* const system = assembly->system;
 
-	for (size_t i = 0; i < system->A.m; i++) {
-		// TODO deal with non-zero conditions
+	elem_t elem;
+	get_elem(&elem, assembly->mesh, i);
 
-		system->b.data[i] -= value * bfm_matrix_get(&system->A, i, node);
-		bfm_matrix_set(&system->A, i, node, 0);
+	size_t const n = system->dim * elem.kind;
+
+	double _ke[ELEM_DOFS * ELEM_DOFS];
+	double* const ke = assembly->loads_only ? NULL : _ke;
+	double fe[ELEM_DOFS];
+
+	if (ke != NULL) {
+		memset(ke, 0, n * n * sizeof *ke);
 	}
 
-	for (size_t i = 0; i < system->A.m; i++) {
-		bfm_matrix_set(&system->A, node, i, 0);
+	memset(fe, 0, n * sizeof *fe);
+
+	int const rv = assembly->axisymmetric ?
+		fill_axisymmetric_elem(&elem, ke, fe, assembly->instance, assembly->node_forces) :
+		fill_elasticity_elem(&elem, ke, fe, assembly->instance, assembly->node_forces, assembly->a, assembly->b, assembly->c);
+
+	if (rv < 0) {
+		return -1;
 	}
 
-	bfm_matrix_set(&system->A, node, node, 1);
-	system->b.data[node] = value;
+	return scatter_elem(system, &elem, i, ke, fe);
 }
 
-static void apply_dirichlet(bfm_system_t* system, bfm_mesh_t* mesh, bfm_condition_t* condition) {
+// batched kernels, one per vector width
+// the baseline one, which every CPU of the architecture can run, is SSE2 on x86-64 & NEON on AArch64, and elsewhere the compiler lowers the vectors to whatever it can
+// on x86, wider ones are compiled for their instruction sets regardless of the ones enabled for the rest of the library (see kernel.c)
+// rules with more than BATCH_POINTS integration points go through the scalar kernel instead
+
+#define BATCH_POINTS 4
+
+#define BATCH_KERNEL(name) name##_base
+#define BATCH_TARGET
+#define BATCH 2
+
+#include "batch_impl.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+# define BATCH_X86
+
+# define BATCH_KERNEL(name) name##_avx
+# define BATCH_TARGET __attribute__((target("avx")))
+# define BATCH 4
+
+# include "batch_impl.h"
+
+# define BATCH_KERNEL(name) name##_avx512
+# define BATCH_TARGET __attribute__((target("avx512f")))
+# define BATCH 8
+
+# include "batch_impl.h"
+#endif
+
+// dispatch
+// the widest batched kernel the CPU supports is picked once, the first time elements are assembled
+
+typedef struct {
+	size_t width;
+	int (*fill)(assembly_t* assembly, size_t const* elems, size_t count);
+} batch_kernel_t;
+
+static batch_kernel_t batch_kernel = {
+	.width = 2,
+	.fill = fill_batch_base,
+};
+
+static pthread_once_t batch_once = PTHREAD_ONCE_INIT;
+
+static void batch_pick(void) {
+#if defined(BATCH_X86)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f")) {
+		batch_kernel = (batch_kernel_t) {
+			.width = 8,
+			.fill = fill_batch_avx512,
+		};
+	}
+
+	else if (__builtin_cpu_supports("avx")) {
+		batch_kernel = (batch_kernel_t) {
+			.width = 4,
+			.fill = fill_batch_avx,
+		};
+	}
+#endif
+}
+
+// fill count elements, either all at once with the batched kernel or one by one
+
+static int fill_elems(assembly_t* assembly, size_t const* elems, size_t count) {
+	if (assembly->batch > 1) {
+		return batch_kernel.fill(assembly, elems, count);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (fill_elem(assembly, elems[i]) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void assembly_task(bfm_team_worker_t* worker) {
+	assembly_t* const assembly = worker->team->data;
+	bfm_mesh_t* const mesh = assembly->mesh;
+	size_t const n_threads = worker->team->n_threads;
+
+	for (size_t i = 0; i < mesh->n_colors; i++) {
+		size_t const start = mesh->color_offsets[i];
+		size_t const len = mesh->color_offsets[i + 1] - start;
+
+		size_t const from = start + len * worker->id / n_threads;
+		size_t const to = start + len * (worker->id + 1) / n_threads;
+
+		// on failure, keep going through the colors so the other threads aren't left waiting at the barrier
+
+		for (size_t j = from; j < to && worker->rv == 0; j += assembly->batch) {
+			if (fill_elems(assembly, &mesh->color_elems[j], BFM_MIN(assembly->batch, to - j)) < 0) {
+				worker->rv = -1;
+			}
+		}
+
+		bfm_team_sync(worker->team);
+	}
+}
+
+// evaluate all body forces at the nodes of the mesh at once, as that's the only place element kernels need them
+// this way, forces defined through callbacks (e.g. from Python) are called once per assembly rather than once per node per integration point per element
+
+static int eval_node_forces(assembly_t* assembly) {
+	bfm_state_t* const state = assembly->system->state;
+	bfm_mesh_t* const mesh = assembly->mesh;
+	size_t const n = mesh->n_nodes * mesh->dim;
+
+	assembly->node_forces = NULL;
+
+	if (!assembly->n_forces) {
+		return 0;
+	}
+
+	double* const node_forces = state->alloc(n * sizeof *node_forces);
+
+	if (node_forces == NULL) {
+		goto err_node_forces_alloc;
+	}
+
+	// only needed when there's more than one force to sum up
+
+	double* const force = assembly->n_forces > 1 ? state->alloc(n * sizeof *force) : node_forces;
+
+	if (force == NULL) {
+		goto err_force_alloc;
+	}
+
+	for (size_t i = 0; i < assembly->n_forces; i++) {
+		if (assembly->forces[i]->dim != mesh->dim) {
+			goto err_eval;
+		}
+
+		if (bfm_force_eval_batch(assembly->forces[i], mesh->n_nodes, mesh->coords, i ? force : node_forces) < 0) {
+			goto err_eval;
+		}
+
+		for (size_t j = 0; i && j < n; j++) {
+			node_forces[j] += force[j];
+		}
+	}
+
+	if (force != node_forces) {
+		state->free(force);
+	}
+
+	assembly->node_forces = node_forces;
+	return 0;
+
+err_eval:
+
+	if (force != node_forces) {
+		state->free(force);
+	}
+
+err_force_alloc:
+
+	state->free(node_forces);
+
+err_node_forces_alloc:
+
+	return -1;
+}
+
+static int assemble_elems(assembly_t* assembly) {
+	bfm_state_t* const state = assembly->system->state;
+	bfm_mesh_t* const mesh = assembly->mesh;
+	bfm_rule_t* const rule = assembly->instance->obj->rule;
+
+	// planar elements can go through the batched kernel
+
+	assembly->batch = 1;
+
+	if (!assembly->axisymmetric && !assembly->loads_only && mesh->dim == 2 && rule->n_points <= BATCH_POINTS) {
+		pthread_once(&batch_once, batch_pick);
+		assembly->batch = batch_kernel.width;
+	}
+
+	// fall back to assembling serially in mesh order if the mesh can't be colored
+
+	if (bfm_mesh_color(mesh) < 0) {
+		for (size_t i = 0; i < mesh->n_elems; i++) {
+			if (fill_elem(assembly, i) < 0) {
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	// roughly 8 flops per entry of the (dim kind)^2 stiffness matrix of each element, per integration point (see fill_elasticity_elem)
+
+	size_t const n = mesh->dim * mesh->kind;
+	double const work = 8. * mesh->n_elems * rule->n_points * n * n;
+
+	return bfm_team_run(state, assembly_task, assembly, work);
+}
+
+static int assemble(assembly_t* assembly) {
+	bfm_state_t* const state = assembly->system->state;
+	bfm_mesh_t* const mesh = assembly->mesh;
+	bfm_rule_t* const rule = assembly->instance->obj->rule;
+
+	// element kernels read shape functions from the rule's tables
+
+	if (rule->kind != mesh->kind) {
+		return -1;
+	}
+
+	if (!rule->tabulated && bfm_rule_tabulate(rule) < 0) {
+		return -1;
+	}
+
+	if (eval_node_forces(assembly) < 0) {
+		return -1;
+	}
+
+	int const rv = assemble_elems(assembly);
+
+	if (assembly->node_forces != NULL) {
+		state->free(assembly->node_forces);
+	}
+
+	return rv;
+}
+
+// boundary conditions
+// b is split into loads (body forces & Neumann conditions) and the lifting of Dirichlet conditions, so that it can be rebuilt for new loads without needing A
+// the lifting is linear in the values of the Dirichlet conditions, so it's kept per unit value of each condition and scaled by their current values when building b
+
+// a DOF constrained by more than one Dirichlet condition takes the value of the last one
+
+static void constrain(bfm_system_t* system, size_t cond, size_t dof, double scale) {
+	system->constrained[dof] = cond + 1;
+	system->scales[dof] = scale;
+}
+
+static void constrain_dirichlet(bfm_system_t* system, bfm_mesh_t* mesh, bfm_condition_t* condition, size_t cond) {
 	size_t const shift = condition->kind == BFM_CONDITION_KIND_DIRICHLET_X ? 0 : 1;
 
 	for (size_t j = 0; j < mesh->n_nodes; j++) {
@@ -381,11 +910,11 @@ static void apply_dirichlet(bfm_system_t* system, bfm_mesh_t* mesh, bfm_conditio
 			continue;
 		}
 
-		apply_constraint(system, j * mesh->dim + shift, condition->value);
+		constrain(system, cond, j * mesh->dim + shift, 1);
 	}
 }
 
-static void apply_dirichlet_normal_tangent(bfm_system_t* system, bfm_mesh_t* mesh, bfm_condition_t* condition) {
+static void constrain_dirichlet_normal_tangent(bfm_system_t* system, bfm_mesh_t* mesh, bfm_condition_t* condition, size_t cond) {
 	for (size_t i = 0; i < mesh->n_nodes; i++) {
 		if (!condition->nodes[i]) {
 			continue;
@@ -394,153 +923,282 @@ static void apply_dirichlet_normal_tangent(bfm_system_t* system, bfm_mesh_t* mes
 		double tx = 0;
 		double ty = 0;
 
-		for (size_t j = 0; j < mesh->n_edges; j++) {
-			if (mesh->edges[j].nodes[0] == i && (mesh->edges[j].elems[1] == -1)) {
-				size_t const n2 = mesh->edges[j].nodes[1];
+		// only the boundary edges of the node matter, each contributing the direction from its other node to this one
 
-				double const length = sqrt(
-					pow(mesh->coords[i * 2 + 0] - mesh->coords[n2 * 2 + 0], 2) +
-					pow(mesh->coords[i * 2 + 1] - mesh->coords[n2 * 2 + 1], 2)
-				);
+		for (size_t k = mesh->node_edge_offsets[i]; k < mesh->node_edge_offsets[i + 1]; k++) {
+			bfm_edge_t* const edge = &mesh->edges[mesh->node_edges[k]];
 
-				tx += (mesh->coords[i * 2 + 0] - mesh->coords[n2 * 2 + 0]) / length / 2;
-				ty += (mesh->coords[i * 2 + 1] - mesh->coords[n2 * 2 + 1]) / length / 2;
+			if (edge->elems[1] != -1) {
+				continue;
 			}
-			else if (mesh->edges[j].nodes[1] == i && (mesh->edges[j].elems[1] == -1)) {
-				size_t const n2 = mesh->edges[j].nodes[0];
 
-				double const length = sqrt(
-					pow(mesh->coords[i * 2 + 0] - mesh->coords[n2 * 2 + 0], 2) +
-					pow(mesh->coords[i * 2 + 1] - mesh->coords[n2 * 2 + 1], 2)
-				);
+			size_t const n2 = edge->nodes[0] == i ? edge->nodes[1] : edge->nodes[0];
 
-				tx += (mesh->coords[i * 2 + 0] - mesh->coords[n2 * 2 + 0]) / length / 2;
-				ty += (mesh->coords[i * 2 + 1] - mesh->coords[n2 * 2 + 1]) / length / 2;
-			}
+			double const length = sqrt(
+				pow(mesh->coords[i * 2 + 0] - mesh->coords[n2 * 2 + 0], 2) +
+				pow(mesh->coords[i * 2 + 1] - mesh->coords[n2 * 2 + 1], 2)
+			);
+
+			tx += (mesh->coords[i * 2 + 0] - mesh->coords[n2 * 2 + 0]) / length / 2;
+			ty += (mesh->coords[i * 2 + 1] - mesh->coords[n2 * 2 + 1]) / length / 2;
 		}
 
-		apply_constraint(system, 2 * i + 0, condition->value * (condition->kind == BFM_CONDITION_KIND_DIRICHLET_TANGENT ? tx : -ty));
-		apply_constraint(system, 2 * i + 1, condition->value * (condition->kind == BFM_CONDITION_KIND_DIRICHLET_TANGENT ? ty : tx));
+		constrain(system, cond, 2 * i + 0, condition->kind == BFM_CONDITION_KIND_DIRICHLET_TANGENT ? tx : -ty);
+		constrain(system, cond, 2 * i + 1, condition->kind == BFM_CONDITION_KIND_DIRICHLET_TANGENT ? ty : tx);
 	}
 }
 
-static int create_planar(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bool stress) {
-	bfm_state_t* const state = instance->state;
-	bfm_obj_t* const obj = instance->obj;
-	bfm_material_t* const material = obj->material;
-	bfm_mesh_t* const mesh = obj->mesh;
-	size_t const n = mesh->n_nodes * mesh->dim;
+static bool is_dirichlet(bfm_condition_t* condition) {
+	return
+		condition->kind == BFM_CONDITION_KIND_DIRICHLET_X ||
+		condition->kind == BFM_CONDITION_KIND_DIRICHLET_Y ||
+		condition->kind == BFM_CONDITION_KIND_DIRICHLET_NORMAL ||
+		condition->kind == BFM_CONDITION_KIND_DIRICHLET_TANGENT;
+}
 
-	// check that mesh is supported
+// find which DOFs are constrained by Dirichlet conditions before assembly, so that they can be eliminated as elements are scattered
 
-	if (mesh->dim != 2) {
+static int build_constraints(bfm_system_t* system, bfm_instance_t* instance) {
+	bfm_state_t* const state = system->state;
+	bfm_mesh_t* const mesh = instance->obj->mesh;
+	size_t const n = system->n;
+
+	system->n_conditions = instance->n_conditions;
+
+	system->constrained = state->alloc(n * sizeof *system->constrained);
+
+	if (system->constrained == NULL) {
 		return -1;
 	}
 
-	if (mesh->kind != BFM_ELEM_KIND_SIMPLEX && mesh->kind != BFM_ELEM_KIND_QUAD) {
+	memset(system->constrained, 0, n * sizeof *system->constrained);
+
+	system->scales = state->alloc(n * sizeof *system->scales);
+
+	if (system->scales == NULL) {
 		return -1;
 	}
 
-	// create system object
+	memset(system->scales, 0, n * sizeof *system->scales);
 
-	if (bfm_system_create(system, state, n) < 0) {
-		return -1;
+	if (!system->n_conditions) {
+		return 0;
 	}
 
-	// go through all elements
+	// each Dirichlet condition gets a slot in lifts, the others don't need one
 
-	elem_t elem;
+	system->lift_slots = state->alloc(system->n_conditions * sizeof *system->lift_slots);
 
-	double const a = !stress ? material->E * (1 - material->nu) / (1 + material->nu) / (1 - 2 * material->nu) : material->E / (1 - material->nu * material->nu);
+	if (system->lift_slots == NULL) {
+		return -1;
+	}
 
-	double const b = !stress ? material->E * material->nu / (1 + material->nu) / (1 - 2 * material->nu) : material->E * material->nu / (1 - material->nu * material->nu);
+	system->n_lifts = 0;
 
-	double const c = material->E / (2 * (1 + material->nu));
+	for (size_t i = 0; i < instance->n_conditions; i++) {
+		system->lift_slots[i] = is_dirichlet(instance->conditions[i]) ? system->n_lifts++ : SIZE_MAX;
+	}
 
-	for (size_t i = 0; i < mesh->n_elems; i++) {
-		get_elem(&elem, mesh, i);
+	if (!system->n_lifts) {
+		return 0;
+	}
 
-		if (fill_elasticity_elem(&elem, system, instance, n_forces, forces, a, b, c) < 0) {
-			return -1;
-		}
+	system->lifts = state->alloc(system->n_lifts * n * sizeof *system->lifts);
+
+	if (system->lifts == NULL) {
+		return -1;
 	}
 
-	// apply conditions
+	memset(system->lifts, 0, system->n_lifts * n * sizeof *system->lifts);
 
 	for (size_t i = 0; i < instance->n_conditions; i++) {
 		bfm_condition_t* const condition = instance->conditions[i];
 
 		if (condition->kind == BFM_CONDITION_KIND_DIRICHLET_X || condition->kind == BFM_CONDITION_KIND_DIRICHLET_Y) {
-			apply_dirichlet(system, mesh, condition);
+			constrain_dirichlet(system, mesh, condition, i);
 		}
 
-		else if (condition->kind == BFM_CONDITION_KIND_NEUMANN_X || condition->kind == BFM_CONDITION_KIND_NEUMANN_Y) {
-			for (size_t j = 0; j < mesh->n_edges; j++) {
-				bfm_edge_t* const edge = &mesh->edges[j];
+		else if (condition->kind == BFM_CONDITION_KIND_DIRICHLET_TANGENT || condition->kind == BFM_CONDITION_KIND_DIRICHLET_NORMAL) {
+			constrain_dirichlet_normal_tangent(system, mesh, condition, i);
+		}
+	}
 
-				size_t const n1 = edge->nodes[0];
-				size_t const n2 = edge->nodes[1];
+	return 0;
+}
 
-				if (!condition->nodes[n1] || !condition->nodes[n2]) {
-					continue;
-				}
+// once assembled, the rows of constrained DOFs just say they take the value of their condition
 
-				double const c2 =
-					pow(mesh->coords[n1 * 2 + 0] - mesh->coords[n2 * 2 + 0], 2) +
-					pow(mesh->coords[n1 * 2 + 1] - mesh->coords[n2 * 2 + 1], 2);
+static int finish_constraints(bfm_system_t* system) {
+	size_t const n = system->n;
 
-				double const jacobian = sqrt(c2) / 2;
+	for (size_t i = 0; i < n; i++) {
+		size_t const cond = system->constrained[i];
 
-				size_t const shift = condition->kind == BFM_CONDITION_KIND_NEUMANN_X ? 0 : 1;
-				system->b.data[n1 * 2 + shift] += jacobian * condition->value;
-				system->b.data[n2 * 2 + shift] += jacobian * condition->value;
-			}
+		if (!cond) {
+			continue;
 		}
 
-		else if (condition->kind == BFM_CONDITION_KIND_NEUMANN_NORMAL || condition->kind == BFM_CONDITION_KIND_NEUMANN_TANGENT) {
-			for (size_t j = 0; j < mesh->n_edges; j++) {
-				bfm_edge_t* const edge = &mesh->edges[j];
+		size_t const diag = system->renumbered ? system->perm.perm[i] : i;
 
-				size_t const n1 = edge->nodes[0];
-				size_t const n2 = edge->nodes[1];
+		if (bfm_matrix_set(&system->A, diag, diag, 1) < 0) {
+			return -1;
+		}
 
-				if (!condition->nodes[n1] || !condition->nodes[n2]) {
-					continue;
-				}
+		system->lifts[system->lift_slots[cond - 1] * n + i] = system->scales[i];
+	}
+
+	return 0;
+}
 
-				// found on https://stackoverflow.com/questions/1243614/how-do-i-calculate-the-normal-vector-of-a-line-segment
+// add a load to b, unless it's overridden by a Dirichlet condition applied after it
+// step is 1 + the index of the Neumann condition the load comes from
 
-				double const dx = mesh->coords[n1 * 2 + 0] - mesh->coords[n2 * 2 + 0];
-				double const dy = mesh->coords[n1 * 2 + 1] - mesh->coords[n2 * 2 + 1];
+static void add_load(bfm_system_t* system, size_t dof, size_t step, double value) {
+	if (system->constrained[dof] > step) {
+		return;
+	}
 
-				// length cancel : jac = length / 2 && vector = delta / length
-				system->b.data[n1 * 2 + 0] += 0.5 * condition->value * (BFM_CONDITION_KIND_NEUMANN_TANGENT == condition->kind ? dx : -dy);
-				system->b.data[n1 * 2 + 1] += 0.5 * condition->value * (BFM_CONDITION_KIND_NEUMANN_TANGENT == condition->kind ? dy : dx);
-				system->b.data[n2 * 2 + 0] += 0.5 * condition->value * (BFM_CONDITION_KIND_NEUMANN_TANGENT == condition->kind ? dx : -dy);
-				system->b.data[n2 * 2 + 1] += 0.5 * condition->value * (BFM_CONDITION_KIND_NEUMANN_TANGENT == condition->kind ? dy : dx);
-			}
+	system->b.data[dof] += value;
+}
+
+static void add_neumann(bfm_system_t* system, bfm_mesh_t* mesh, bfm_condition_t* condition, size_t cond) {
+	size_t const shift = condition->kind == BFM_CONDITION_KIND_NEUMANN_X ? 0 : 1;
+
+	for (size_t j = 0; j < condition->n_edges; j++) {
+		bfm_edge_t* const edge = &mesh->edges[condition->edges[j]];
+
+		size_t const n1 = edge->nodes[0];
+		size_t const n2 = edge->nodes[1];
+
+		double const c2 =
+			pow(mesh->coords[n1 * 2 + 0] - mesh->coords[n2 * 2 + 0], 2) +
+			pow(mesh->coords[n1 * 2 + 1] - mesh->coords[n2 * 2 + 1], 2);
+
+		double const jacobian = sqrt(c2) / 2;
+
+		// axisymmetric loads are weighted by the radius
+
+		double fac = 1;
+
+		if (system->axisymmetric) {
+			double const r1 =
+				mesh->coords[n1 * 2 + 0] * (1 - 1 / sqrt(3)) / 2 +
+				mesh->coords[n1 * 2 + 1] * (1 + 1 / sqrt(3)) / 2;
+
+			double const r2 =
+				mesh->coords[n2 * 2 + 0] * (1 - 1 / sqrt(3)) / 2 +
+				mesh->coords[n2 * 2 + 1] * (1 + 1 / sqrt(3)) / 2;
+
+			fac = r1 + r2;
 		}
-		else if (condition->kind == BFM_CONDITION_KIND_DIRICHLET_TANGENT || condition->kind == BFM_CONDITION_KIND_DIRICHLET_NORMAL) {
-			apply_dirichlet_normal_tangent(system, mesh, condition);
+
+		add_load(system, n1 * 2 + shift, cond + 1, fac * jacobian * condition->value);
+		add_load(system, n2 * 2 + shift, cond + 1, fac * jacobian * condition->value);
+	}
+}
+
+static void add_neumann_normal_tangent(bfm_system_t* system, bfm_mesh_t* mesh, bfm_condition_t* condition, size_t cond) {
+	bool const tangent = condition->kind == BFM_CONDITION_KIND_NEUMANN_TANGENT;
+
+	for (size_t j = 0; j < condition->n_edges; j++) {
+		bfm_edge_t* const edge = &mesh->edges[condition->edges[j]];
+
+		size_t const n1 = edge->nodes[0];
+		size_t const n2 = edge->nodes[1];
+
+		// found on https://stackoverflow.com/questions/1243614/how-do-i-calculate-the-normal-vector-of-a-line-segment
+
+		double const dx = mesh->coords[n1 * 2 + 0] - mesh->coords[n2 * 2 + 0];
+		double const dy = mesh->coords[n1 * 2 + 1] - mesh->coords[n2 * 2 + 1];
+
+		// length cancel : jac = length / 2 && vector = delta / length
+		add_load(system, n1 * 2 + 0, cond + 1, 0.5 * condition->value * (tangent ? dx : -dy));
+		add_load(system, n1 * 2 + 1, cond + 1, 0.5 * condition->value * (tangent ? dy : dx));
+		add_load(system, n2 * 2 + 0, cond + 1, 0.5 * condition->value * (tangent ? dx : -dy));
+		add_load(system, n2 * 2 + 1, cond + 1, 0.5 * condition->value * (tangent ? dy : dx));
+	}
+}
+
+// Neumann conditions go through their edges
+// these are resolved again on each assembly, as the nodes of a condition can be changed in between, and this is linear in the number of nodes anyway
+
+static int resolve_condition_edges(bfm_instance_t* instance) {
+	for (size_t i = 0; i < instance->n_conditions; i++) {
+		bfm_condition_t* const condition = instance->conditions[i];
+
+		if (is_dirichlet(condition)) {
+			continue;
+		}
+
+		if (bfm_condition_resolve_edges(condition) < 0) {
+			return -1;
 		}
 	}
 
 	return 0;
 }
 
-int bfm_system_create_planar_strain(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces) {
-	return create_planar(system, instance, n_forces, forces, false);
-}
+// finish building b once body forces have been assembled into it
+// loads (but not the lifting, which doesn't depend on the material) are scaled by scale
+
+static void add_condition_loads(bfm_system_t* system, bfm_instance_t* instance, double scale) {
+	bfm_mesh_t* const mesh = instance->obj->mesh;
+	size_t const n = system->n;
+
+	// body forces on constrained DOFs are overridden by the conditions
+
+	for (size_t i = 0; i < n; i++) {
+		if (system->constrained[i]) {
+			system->b.data[i] = 0;
+		}
+	}
+
+	// Neumann conditions
+	// normal & tangent ones aren't supported for axisymmetric systems
+
+	for (size_t i = 0; i < instance->n_conditions; i++) {
+		bfm_condition_t* const condition = instance->conditions[i];
+
+		if (condition->kind == BFM_CONDITION_KIND_NEUMANN_X || condition->kind == BFM_CONDITION_KIND_NEUMANN_Y) {
+			add_neumann(system, mesh, condition, i);
+		}
+
+		else if (!system->axisymmetric && (condition->kind == BFM_CONDITION_KIND_NEUMANN_NORMAL || condition->kind == BFM_CONDITION_KIND_NEUMANN_TANGENT)) {
+			add_neumann_normal_tangent(system, mesh, condition, i);
+		}
+	}
+
+	// loads on constrained DOFs (Neumann loads applied after a Dirichlet condition) end up as is in the solution, so they aren't scaled
+
+	if (scale != 1) {
+		for (size_t i = 0; i < n; i++) {
+			if (!system->constrained[i]) {
+				system->b.data[i] *= scale;
+			}
+		}
+	}
 
-int bfm_system_create_planar_stress(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces) {
-	return create_planar(system, instance, n_forces, forces, true);
+	// lifting of Dirichlet conditions, for their current values
+
+	for (size_t i = 0; i < instance->n_conditions; i++) {
+		bfm_condition_t* const condition = instance->conditions[i];
+
+		if (system->lift_slots[i] == SIZE_MAX || condition->value == 0) {
+			continue;
+		}
+
+		double const* const lift = &system->lifts[system->lift_slots[i] * n];
+
+		for (size_t j = 0; j < n; j++) {
+			system->b.data[j] += condition->value * lift[j];
+		}
+	}
 }
 
-int bfm_system_create_axisymmetric_strain(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces) {
+static int create_elasticity(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bfm_system_layout_t const* layout, bool axisymmetric, double a, double b, double c) {
 	bfm_state_t* const state = instance->state;
 	bfm_obj_t* const obj = instance->obj;
 	bfm_mesh_t* const mesh = obj->mesh;
-	size_t const n = mesh->n_nodes * mesh->dim;
 
 	// check that mesh is supported
 
@@ -553,70 +1211,144 @@ int bfm_system_create_axisymmetric_strain(bfm_system_t* system, bfm_instance_t*
 	}
 
 	// create system object
+	// planar elasticity stiffness matrices are symmetric, axisymmetric ones aren't
 
-	if (bfm_system_create(system, state, n) < 0) {
+	if (bfm_system_create(system, state, mesh) < 0) {
 		return -1;
 	}
 
-	// go through all elements
+	system->symmetric = !axisymmetric;
+	system->axisymmetric = axisymmetric;
 
-	elem_t elem;
+	// when asked to, order the mesh before assembly and swap the sparse matrix for a band matrix in the renumbered order
+	// this way, the band factorization needs no conversion at all
 
-	for (size_t i = 0; i < mesh->n_elems; i++) {
-		get_elem(&elem, mesh, i);
+	if (layout != NULL && layout->band) {
+		system->ordering = layout->ordering;
 
-		if (fill_axisymmetric_elem(&elem, system, instance, n_forces, forces) < 0) {
-			return -1;
+		if (create_perm(system) < 0) {
+			goto err;
 		}
+
+		bfm_matrix_t A;
+
+		if (create_band(system, &A) < 0) {
+			goto err;
+		}
+
+		bfm_matrix_destroy(&system->A);
+		memcpy(&system->A, &A, sizeof A);
+
+		system->renumbered = true;
+	}
+
+	// find constrained DOFs first, as they're eliminated during assembly
+
+	if (resolve_condition_edges(instance) < 0) {
+		goto err;
+	}
+
+	if (build_constraints(system, instance) < 0) {
+		goto err;
+	}
+
+	// go through all elements, assembling stiffness and body forces
+
+	assembly_t assembly = {
+		.system = system,
+		.instance = instance,
+		.mesh = mesh,
+		.n_forces = n_forces,
+		.forces = forces,
+		.axisymmetric = axisymmetric,
+		.loads_only = false,
+		.a = a,
+		.b = b,
+		.c = c,
+	};
+
+	if (assemble(&assembly) < 0) {
+		goto err;
 	}
 
 	// apply conditions
 
-	for (size_t i = 0; i < instance->n_conditions; i++) {
-		bfm_condition_t* const condition = instance->conditions[i];
+	if (finish_constraints(system) < 0) {
+		goto err;
+	}
 
-		if (condition->kind == BFM_CONDITION_KIND_DIRICHLET_X || condition->kind == BFM_CONDITION_KIND_DIRICHLET_Y) {
-			apply_dirichlet(system, mesh, condition);
-		}
+	add_condition_loads(system, instance, 1);
 
-		else if (condition->kind == BFM_CONDITION_KIND_DIRICHLET_TANGENT || condition->kind == BFM_CONDITION_KIND_DIRICHLET_NORMAL) {
-			apply_dirichlet_normal_tangent(system, mesh, condition);
-		}
+	return 0;
 
-		else if (condition->kind == BFM_CONDITION_KIND_NEUMANN_X || condition->kind == BFM_CONDITION_KIND_NEUMANN_Y) {
-			for (size_t j = 0; j < mesh->n_edges; j++) {
-				bfm_edge_t* const edge = &mesh->edges[j];
+err:
 
-				size_t const n1 = edge->nodes[0];
-				size_t const n2 = edge->nodes[1];
+	bfm_system_destroy(system);
+	return -1;
+}
 
-				if (!condition->nodes[n1] || !condition->nodes[n2]) {
-					continue;
-				}
+int bfm_system_create_planar_strain(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bfm_system_layout_t const* layout) {
+	bfm_material_t* const material = instance->obj->material;
 
-				double const r1 =
-					mesh->coords[n1 * 2 + 0] * (1 - 1 / sqrt(3)) / 2 +
-					mesh->coords[n1 * 2 + 1] * (1 + 1 / sqrt(3)) / 2;
+	double const a = material->E * (1 - material->nu) / (1 + material->nu) / (1 - 2 * material->nu);
+	double const b = material->E * material->nu / (1 + material->nu) / (1 - 2 * material->nu);
+	double const c = material->E / (2 * (1 + material->nu));
 
-				double const r2 =
-					mesh->coords[n2 * 2 + 0] * (1 - 1 / sqrt(3)) / 2 +
-					mesh->coords[n2 * 2 + 1] * (1 + 1 / sqrt(3)) / 2;
+	return create_elasticity(system, instance, n_forces, forces, layout, false, a, b, c);
+}
 
-				double const fac = r1 + r2;
+int bfm_system_create_planar_stress(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bfm_system_layout_t const* layout) {
+	bfm_material_t* const material = instance->obj->material;
 
-				double const c2 =
-					pow(mesh->coords[n1 * 2 + 0] - mesh->coords[n2 * 2 + 0], 2) +
-					pow(mesh->coords[n1 * 2 + 1] - mesh->coords[n2 * 2 + 1], 2);
+	double const a = material->E / (1 - material->nu * material->nu);
+	double const b = material->E * material->nu / (1 - material->nu * material->nu);
+	double const c = material->E / (2 * (1 + material->nu));
 
-				double const jacobian = sqrt(c2) / 2;
+	return create_elasticity(system, instance, n_forces, forces, layout, false, a, b, c);
+}
 
-				size_t const shift = condition->kind == BFM_CONDITION_KIND_NEUMANN_X ? 0 : 1;
+int bfm_system_create_axisymmetric_strain(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, bfm_system_layout_t const* layout) {
+	// material constants are computed by the axisymmetric kernel itself
 
-				system->b.data[n1 * 2 + shift] += fac * jacobian * condition->value;
-				system->b.data[n2 * 2 + shift] += fac * jacobian * condition->value;
-			}
+	return create_elasticity(system, instance, n_forces, forces, layout, true, 0, 0, 0);
+}
+
+int bfm_system_assemble_loads_scaled(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces, double scale) {
+	// the conditions must be the same as when the system was created, as their lifting & which DOFs they constrain are reused
+
+	if (system->constrained == NULL || instance->n_conditions != system->n_conditions) {
+		return -1;
+	}
+
+	if (resolve_condition_edges(instance) < 0) {
+		return -1;
+	}
+
+	memset(system->b.data, 0, system->n * sizeof *system->b.data);
+
+	// body forces, which are the only loads that need going through the elements
+
+	if (n_forces) {
+		assembly_t assembly = {
+			.system = system,
+			.instance = instance,
+			.mesh = instance->obj->mesh,
+			.n_forces = n_forces,
+			.forces = forces,
+			.axisymmetric = system->axisymmetric,
+			.loads_only = true,
+		};
+
+		if (assemble(&assembly) < 0) {
+			return -1;
 		}
 	}
 
+	add_condition_loads(system, instance, scale);
+
 	return 0;
 }
+
+int bfm_system_assemble_loads(bfm_system_t* system, bfm_instance_t* instance, size_t n_forces, bfm_force_t** forces) {
+	return bfm_system_assemble_loads_scaled(system, instance, n_forces, forces, 1);
+}
@@ -0,0 +1,94 @@
+#include <bfm/math.h>
+#include <bfm/team.h>
+
+#define TEAM_THREAD_WORK (1ul << 22) // rough number of flops each thread needs for spawning it to be worth it
+
+static void* team_worker(void* _worker) {
+	bfm_team_worker_t* const worker = _worker;
+	bfm_team_t* const team = worker->team;
+
+	// wait for all the threads to be spawned, so that we know how many there are
+
+	pthread_mutex_lock(&team->start);
+	pthread_mutex_unlock(&team->start);
+
+	if (team->abort) {
+		return NULL;
+	}
+
+	team->task(worker);
+	return NULL;
+}
+
+int bfm_team_run(bfm_state_t* state, bfm_team_task_t task, void* data, double work) {
+	size_t const n_threads = BFM_MAX(BFM_MIN(state->n_threads, (size_t) (work / TEAM_THREAD_WORK)), 1);
+
+	bfm_team_worker_t* const workers = state->alloc(n_threads * sizeof *workers);
+
+	if (workers == NULL) {
+		return -1;
+	}
+
+	bfm_team_t team = {
+		.data = data,
+		.task = task,
+		.abort = false,
+	};
+
+	for (size_t i = 0; i < n_threads; i++) {
+		workers[i].team = &team;
+		workers[i].id = i;
+		workers[i].rv = 0;
+	}
+
+	// if not all threads could be spawned, just make do with the ones that were
+
+	pthread_mutex_init(&team.start, NULL);
+	pthread_mutex_lock(&team.start);
+
+	size_t n_spawned = 1;
+
+	while (n_spawned < n_threads) {
+		if (pthread_create(&workers[n_spawned].thread, NULL, team_worker, &workers[n_spawned]) != 0) {
+			break;
+		}
+
+		n_spawned++;
+	}
+
+	team.n_threads = n_spawned;
+
+	if (n_spawned > 1 && pthread_barrier_init(&team.barrier, NULL, n_spawned) != 0) {
+		team.abort = true;
+	}
+
+	pthread_mutex_unlock(&team.start);
+	team_worker(&workers[0]);
+
+	int rv = team.abort ? -1 : 0;
+
+	for (size_t i = 0; i < n_spawned; i++) {
+		if (i > 0) {
+			pthread_join(workers[i].thread, NULL);
+		}
+
+		if (workers[i].rv < 0) {
+			rv = -1;
+		}
+	}
+
+	if (n_spawned > 1 && !team.abort) {
+		pthread_barrier_destroy(&team.barrier);
+	}
+
+	pthread_mutex_destroy(&team.start);
+	state->free(workers);
+
+	return rv;
+}
+
+void bfm_team_sync(bfm_team_t* team) {
+	if (team->n_threads > 1) {
+		pthread_barrier_wait(&team->barrier);
+	}
+}
@@ -1,7 +1,7 @@
 from .bfm import Bfm
 from .condition import Condition
 from .ez import Ez_lepl1110
-from .force import Force, Force_none, Force_linear
+from .force import Force, Force_none, Force_linear, Force_funky
 from .instance import CInstance, Instance
 from .mesh import Mesh, Mesh_lepl1110, Mesh_wavefront
 from .material import CMaterial, Material
@@ -34,4 +34,28 @@ class __Force_linear(Force):
 class Force_linear(__Force_linear):
 	... # to call __init_subclass__
 
-# TODO Force_funky
+class Force_funky(Force):
+	# func is given the positions at which to evaluate the force, as a list of tuples, and returns the force at each of them in the same form
+	# it is called once per assembly with the positions of all the nodes, rather than once per node
+
+	def __init__(self, dim: int, func):
+		super().__init__(dim)
+
+		self.func = func
+		self.handle = ffi.new_handle(self) # the C side only holds onto this, so keep it alive along with the force
+
+		assert not lib.bfm_force_set_funky_batch(self.c_force, lib.pybfm_force_funky_batch, self.handle)
+
+@ffi.def_extern(error=-1)
+def pybfm_force_funky_batch(c_force, n, c_pos, c_force_ref, data):
+	force = ffi.from_handle(data)
+	dim = c_force.dim
+
+	flat = ffi.unpack(c_pos, n * dim)
+	pos = [tuple(flat[i * dim:(i + 1) * dim]) for i in range(n)]
+
+	for i, vec in enumerate(force.func(pos)):
+		for j in range(dim):
+			c_force_ref[i * dim + j] = vec[j]
+
+	return 0
@@ -15,6 +15,10 @@ if __name__ == "__main__":
 		"bfm/material.h",
 		"bfm/matrix.h",
 		"bfm/mesh.h",
+		"bfm/graph.h",
+		"bfm/perm.h",
+		"bfm/symbolic.h",
+		"bfm/chol.h",
 		"bfm/condition.h",
 		"bfm/shape.h",
 		"bfm/rule.h",
@@ -22,7 +26,6 @@ if __name__ == "__main__":
 		"bfm/instance.h",
 		"bfm/sim.h",
 		"bfm/ez.h",
-		"bfm/perm.h",
 		"bfm/system.h",
 	]
 
@@ -39,6 +42,12 @@ if __name__ == "__main__":
 
 			ffi.cdef(src)
 
+	# callbacks into Python
+
+	ffi.cdef("""
+		extern "Python" int pybfm_force_funky_batch(bfm_force_t* force, size_t n, double const* pos, double* force_ref, void* data);
+	""")
+
 	ffi.set_source(
 		"pybfm.bfm.libbfm",
 		includes,
@@ -1,5 +1,6 @@
 import pyglet.gl as gl
 
+from .condition import Condition
 from .force import Force
 from .instance import Instance
 from .libbfm import lib, ffi
@@ -13,6 +14,20 @@ class CSim:
 	PLANAR_STRESS       = 2
 	AXISYMMETRIC_STRAIN = 3
 
+	SOLVER_DIRECT = 0
+	SOLVER_PCG    = 1
+	SOLVER_SPARSE = 2
+
+	PRECOND_NONE   = 0
+	PRECOND_JACOBI = 1
+	PRECOND_SGS    = 2
+	PRECOND_IC0    = 3
+
+	ORDERING_RCM   = 0
+	ORDERING_SLOAN = 1
+	ORDERING_ND    = 2
+	ORDERING_AMD   = 3
+
 	def __init__(self, c_sim, instances: list[Instance], kind: int):
 		self.c_sim = c_sim
 		self.instances = instances
@@ -30,9 +45,86 @@ class CSim:
 	def add_force(self, force: Force):
 		assert not lib.bfm_sim_add_force(self.c_sim, force.c_force)
 
+	def set_solver(self, solver: int):
+		assert not lib.bfm_sim_set_solver(self.c_sim, solver)
+
+	def set_pcg(self, precond: int = PRECOND_IC0, tol: float = 1e-10, max_iter: int = 0):
+		assert not lib.bfm_sim_set_pcg(self.c_sim, precond, tol, max_iter)
+
+	def set_ordering(self, ordering: int):
+		assert not lib.bfm_sim_set_ordering(self.c_sim, ordering)
+
+	def ordering_stats(self) -> list[tuple[int, int, int] | None]:
+		# bandwidth, profile & predicted nnz(L) of the renumbered system of each instance, if it has one from the last run
+
+		stats = []
+
+		for instance in self.instances:
+			system = instance.c_instance.system
+
+			if system == ffi.NULL:
+				stats.append(None)
+				continue
+
+			stats.append((system.perm.bandwidth, system.perm.profile, system.perm.nnz_l))
+
+		return stats
+
 	def run(self):
 		assert not lib.bfm_sim_run(self.c_sim)
 
+	def resolve(self):
+		assert not lib.bfm_sim_resolve(self.c_sim)
+
+	def run_load_cases(self, cases: list[tuple[list[Force], dict[Condition, float]]]) -> list[list[list[float]]]:
+		# each load case is a list of forces and new values for some conditions
+		# returns the effects of each load case, for each instance
+
+		c_cases = ffi.new("bfm_load_case_t[]", len(cases))
+		keep_alive = [] # cffi frees these as soon as they're garbage collected
+
+		for c_case, (forces, values) in zip(c_cases, cases):
+			c_forces = ffi.new("bfm_force_t*[]", [force.c_force for force in forces])
+			c_conditions = ffi.new("bfm_condition_t*[]", [condition.c_condition for condition in values])
+			c_values = ffi.new("double[]", list(values.values()))
+
+			keep_alive += [c_forces, c_conditions, c_values]
+
+			c_case.n_forces = len(forces)
+			c_case.forces = c_forces
+			c_case.n_conditions = len(values)
+			c_case.conditions = c_conditions
+			c_case.values = c_values
+
+		assert not lib.bfm_sim_run_load_cases(self.c_sim, len(cases), c_cases)
+
+		effects = []
+
+		for instance in self.instances:
+			c_instance = instance.c_instance
+			n = c_instance.n_effects
+
+			effects.append([[c_instance.case_effects[c * n + i] for i in range(n)] for c in range(len(cases))])
+
+		return effects
+
+	def run_sweep(self, params: list[tuple[float, float, float]]) -> list[list[list[float]]]:
+		# each parameter set is a (E, nu, rho) tuple, applied in turn to the materials of all instances
+		# returns the effects of each parameter set, for each instance
+
+		c_params = ffi.new("bfm_sweep_params_t[]", [{"E": E, "nu": nu, "rho": rho} for E, nu, rho in params])
+		assert not lib.bfm_sim_run_sweep(self.c_sim, len(params), c_params)
+
+		effects = []
+
+		for instance in self.instances:
+			c_instance = instance.c_instance
+			n = c_instance.n_effects
+
+			effects.append([[c_instance.sweep_effects[p * n + i] for i in range(n)] for p in range(len(params))])
+
+		return effects
+
 	# visualisation functions
 
 	def show(self):